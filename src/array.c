@@ -86,6 +86,76 @@ node_free(
 
 //------------------------------------------------------------------------------
 
+// Small arrays, such as the environment of a function call, map hashes
+// positionally in a flat node rather than building a trie; the flat node
+// is promoted to a trie once an index beyond FLAT_MAX_SIZE is mapped.
+
+enum {
+	FLAT_MAX_SIZE = 8,
+	FLAT_TAG      = 2,
+};
+
+struct flat {
+	uint32_t mapped;
+	uint64_t hash[FLAT_MAX_SIZE];
+};
+
+static struct flat *flat_free_list = NULL;
+
+static inline bool
+map_is_flat(
+	uintptr_t map
+) {
+	return (map & FLAT_TAG) != 0;
+}
+
+static inline struct flat *
+flat_of(
+	uintptr_t map
+) {
+	return (struct flat *)(map & ~(uintptr_t)FLAT_TAG);
+}
+
+static struct flat *
+flat_alloc(
+	void
+) {
+	struct flat *flat = flat_free_list;
+	if(flat) {
+		flat_free_list = *(struct flat **)flat;
+	} else {
+		flat = malloc(sizeof(*flat));
+	}
+	if(flat) {
+		flat->mapped = 0;
+	}
+
+	return flat;
+}
+
+static void
+flat_free(
+	struct flat *flat
+) {
+	*(struct flat **)flat = flat_free_list;
+	flat_free_list        = flat;
+	return;
+}
+
+static void
+map_free(
+	uintptr_t map
+) {
+	if(map_is_flat(map)) {
+		flat_free(flat_of(map));
+	} else {
+		node_free(untag_pointer(map), node_is_leaf(map));
+	}
+	return;
+}
+
+//------------------------------------------------------------------------------
+
 bool
 array_expand(
 	Array arr,
@@ -117,6 +187,12 @@ array_clear(
 	Array arr
 ) {
 	if(arr) {
+		if(arr->map != (uintptr_t)NULL) {
+			map_free(arr->map);
+
+			arr->map = (uintptr_t)NULL;
+		}
+
 		arr->length = 0;
 	}
 }
@@ -127,7 +203,7 @@ array_free(
 ) {
 	if(arr) {
 		if(arr->map != (uintptr_t)NULL) {
-			node_free(untag_pointer(arr->map), node_is_leaf(arr->map));
+			map_free(arr->map);
 
 			arr->map = (uintptr_t)NULL;
 		}
@@ -143,9 +219,9 @@ array_free(
 
 //------------------------------------------------------------------------------
 
-size_t
-array_map_index(
-	Array       arr,
+static size_t
+node_map_index(
+	uintptr_t  *root,
 	uint64_t    hash,
 	size_t      index
 ) {
@@ -154,10 +230,10 @@ array_map_index(
 		return ~SIZE_C(0);
 	}
 
-	if(arr->map != (uintptr_t)NULL) {
-		bool         is_leaf =  node_is_leaf(arr->map);
-		struct node *node    =  untag_pointer(arr->map);
-		uintptr_t   *here    = &arr->map;
+	if(*root != (uintptr_t)NULL) {
+		bool         is_leaf =  node_is_leaf(*root);
+		struct node *node    =  untag_pointer(*root);
+		uintptr_t   *here    = root;
 
 		for(int o = 0; ; o += BITS_PER_NODE ) {
 			struct node *leaf;
@@ -284,7 +360,7 @@ array_map_index(
 		if(leaf) {
 			leaf->map    = hash;
 			leaf->ptr[0] = uip;
-			arr->map     = (uintptr_t)leaf;
+			*root        = (uintptr_t)leaf;
 
 			return index;
 		}
@@ -293,6 +369,48 @@ array_map_index(
 	return ~SIZE_C(0);
 }
 
+size_t
+array_map_index(
+	Array       arr,
+	uint64_t    hash,
+	size_t      index
+) {
+	if((arr->map == (uintptr_t)NULL) && (index < FLAT_MAX_SIZE)) {
+		struct flat *flat = flat_alloc();
+		if(!flat) {
+			return ~SIZE_C(0);
+		}
+		arr->map = (uintptr_t)flat | FLAT_TAG;
+	}
+
+	if(map_is_flat(arr->map)) {
+		struct flat *flat = flat_of(arr->map);
+
+		if(index < FLAT_MAX_SIZE) {
+			flat->hash[index]  = hash;
+			flat->mapped      |= UINT32_C(1) << index;
+			return index;
+		}
+
+		uintptr_t map = (uintptr_t)NULL;
+		for(size_t i = 0; i < FLAT_MAX_SIZE; i++) {
+			if((flat->mapped & (UINT32_C(1) << i))
+				&& (node_map_index(&map, flat->hash[i], i) != i)
+			) {
+				if(map != (uintptr_t)NULL) {
+					map_free(map);
+				}
+				return ~SIZE_C(0);
+			}
+		}
+
+		flat_free(flat);
+		arr->map = map;
+	}
+
+	return node_map_index(&arr->map, hash, index);
+}
+
 size_t
 array_get_index(
 	Array       arr,
@@ -306,7 +424,20 @@ array_get_index(
 	void const *key,
 	size_t      n
 ) {
-	if(arr->map != (uintptr_t)NULL) {
+	if(map_is_flat(arr->map)) {
+		struct flat const *flat = flat_of(arr->map);
+
+		size_t index = 0;
+		for(uint32_t mapped = flat->mapped; mapped; mapped >>= 1, ++index) {
+			if((mapped & 1)
+				&& (flat->hash[index] == hash)
+				&& (cmp(arr, index, key, n) == 0)
+			) {
+				return index;
+			}
+		}
+
+	} else if(arr->map != (uintptr_t)NULL) {
 		bool               is_leaf = node_is_leaf(arr->map);
 		struct node const *node    = untag_pointer(arr->map);
 
@@ -346,6 +477,48 @@ array_get_index(
 	return ~SIZE_C(0);
 }
 
+bool
+array_has_hash(
+	Array       arr,
+	uint64_t    hash
+) {
+	if(map_is_flat(arr->map)) {
+		struct flat const *flat = flat_of(arr->map);
+
+		size_t index = 0;
+		for(uint32_t mapped = flat->mapped; mapped; mapped >>= 1, ++index) {
+			if((mapped & 1) && (flat->hash[index] == hash)) {
+				return true;
+			}
+		}
+
+	} else if(arr->map != (uintptr_t)NULL) {
+		bool               is_leaf = node_is_leaf(arr->map);
+		struct node const *node    = untag_pointer(arr->map);
+
+		for(int o = 0; ; o += BITS_PER_NODE ) {
+			if(is_leaf) {
+				return node->map == hash;
+			}
+
+			int      const i = (hash >> o) & NODE_BIT_MASK;
+			uint64_t const b = UINT64_C(1) << i;
+			uint64_t const x = node->map & (b - 1);
+			int      const j = popcount64(x);
+
+			if(!(node->map & b)) {
+				break;
+			}
+
+			is_leaf = node_is_leaf(node->ptr[j]);
+			node    = untag_pointer(node->ptr[j]);
+
+		}	// for
+	}
+
+	return false;
+}
+
 static int
 array_foreach_node(
 	uintptr_t map,
@@ -388,9 +561,85 @@ array_foreach(
 ) {
 	int res = 0;
 
-	if(arr->map != (uintptr_t)NULL) {
+	if(map_is_flat(arr->map)) {
+		struct flat const *flat = flat_of(arr->map);
+
+		for(size_t index = 0; (res == 0) && (index < FLAT_MAX_SIZE); ++index) {
+			if(flat->mapped & (UINT32_C(1) << index)) {
+				res = callback(context, index, flat->hash[index]);
+			}
+		}
+
+	} else if(arr->map != (uintptr_t)NULL) {
 		res = array_foreach_node(arr->map, callback, context);
 	}
 
 	return res;
 }
+
+//------------------------------------------------------------------------------
+
+static uintptr_t
+node_clone(
+	uintptr_t map
+) {
+	bool               is_leaf = node_is_leaf(map);
+	struct node const *node    = untag_pointer(map);
+	size_t             n;
+
+	if(is_leaf) {
+		for(n = 1; !is_leaf_last_entry(node->ptr[n - 1]); ++n)
+			;
+	} else {
+		n = (size_t)popcount64(node->map);
+	}
+
+	struct node *copy = malloc(sizeof(*copy) + (capacity_of(n) * sizeof(uintptr_t)));
+	if(!copy) {
+		return (uintptr_t)NULL;
+	}
+	copy->map = node->map;
+
+	if(is_leaf) {
+		memcpy(copy->ptr, node->ptr, n * sizeof(uintptr_t));
+		return (uintptr_t)copy;
+	}
+
+	for(size_t i = 0; i < n; ++i) {
+		copy->ptr[i] = node_clone(node->ptr[i]);
+		if(copy->ptr[i] == (uintptr_t)NULL) {
+			while(i-- > 0) {
+				node_free(untag_pointer(copy->ptr[i]), node_is_leaf(copy->ptr[i]));
+			}
+			free(copy);
+			return (uintptr_t)NULL;
+		}
+	}
+
+	return tag_pointer(copy);
+}
+
+bool
+array_map_clone(
+	Array arr,
+	Array from
+) {
+	assert(arr->map == (uintptr_t)NULL);
+
+	if(map_is_flat(from->map)) {
+		struct flat *flat = flat_alloc();
+		if(!flat) {
+			return false;
+		}
+		*flat    = *flat_of(from->map);
+		arr->map = (uintptr_t)flat | FLAT_TAG;
+
+	} else if(from->map != (uintptr_t)NULL) {
+		arr->map = node_clone(from->map);
+		if(arr->map == (uintptr_t)NULL) {
+			return false;
+		}
+	}
+
+	return true;
+}
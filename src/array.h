@@ -119,6 +119,18 @@ array_get_index(
 	size_t      n
 );
 
+extern bool
+array_has_hash(
+	Array       arr,
+	uint64_t    hash
+);
+
+extern bool
+array_map_clone(
+	Array arr,
+	Array from
+);
+
 extern int
 array_foreach(
 	Array arr,
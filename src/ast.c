@@ -22,16 +22,17 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 #include "ast.h"
+#include "cache.h"
 #include "env.h"
 #include "odt.h"
 #include "hash.h"
 #include "strlib.h"
-#include "marray.h"
 #include "assert.h"
 #include "utf8.h"
 #include "parse.h"
 #include "lex.h"
 #include "gc.h"
+#include "trace.h"
 #include <stdlib.h>
 #include <stdarg.h>
 
@@ -39,6 +40,13 @@ SOFTWARE.
 
 Ast ZEN = NULL;
 
+#define IMMEDIATE_INTEGERS    256
+#define IMMEDIATE_CHARACTERS  256
+
+static Ast immediate_boolean[2];
+static Ast immediate_integer[IMMEDIATE_INTEGERS];
+static Ast immediate_character[IMMEDIATE_CHARACTERS];
+
 //------------------------------------------------------------------------------
 
 static inline String
@@ -153,17 +161,20 @@ makopr(
 
 #define MIN_GC_THRESHOLD  ((CHAR_BIT * sizeof(size_t)) * 1024)
 #define MAX_GC_THRESHOLD  BIT_ROUND(SIZE_MAX/2)
+#ifndef NURSERY_SIZE
+#define NURSERY_SIZE      MIN_GC_THRESHOLD
+#endif
 
 static size_t gc_threshold      =  MIN_GC_THRESHOLD;
 static size_t low_gc_threshold  =  MIN_GC_THRESHOLD / 3;
 static size_t high_gc_threshold = (MIN_GC_THRESHOLD / 3) * 2;
 
-void
-run_gc(
+size_t gc_step_size = 0;
+
+static void
+adjust_gc_threshold(
 	void
 ) {
-	gc_mark_and_sweep();
-
 	if(gc_total_size() > high_gc_threshold) {
 		if(gc_threshold < MAX_GC_THRESHOLD) {
 			gc_threshold     *= 2;
@@ -182,12 +193,48 @@ run_gc(
 	return;
 }
 
+// Collects the young generation, unless the heap as a whole has grown
+// past the threshold, when everything is collected and the threshold is
+// adjusted to the size that survived.
+//
+// With a non-zero gc_step_size the old generation is collected a step at
+// a time, each step after a young collection; should the heap double
+// before it is done the rest is collected in one go.
+void
+run_gc(
+	void
+) {
+	bool const collecting = gc_collecting();
+
+	if(!collecting && (gc_total_size() < gc_threshold)) {
+		gc_mark_and_sweep_young();
+		return;
+	}
+
+	if(collecting || gc_step_size) {
+		size_t budget = SIZE_MAX;
+		if(gc_step_size && ((gc_total_size() / 2) < gc_threshold)) {
+			budget = gc_step_size;
+		}
+
+		gc_mark_and_sweep_young();
+		if(!gc_mark_and_sweep_step(budget)) {
+			return;
+		}
+
+	} else {
+		gc_mark_and_sweep();
+	}
+
+	adjust_gc_threshold();
+
+	return;
+}
+
 //------------------------------------------------------------------------------
 
 #ifndef NPOOL
-static size_t        sizeof_ast = 0;
-static void   const *free_list  = NULL;
-static struct array  ast_pool   = ARRAY();
+static struct gc_class *ast_class = NULL;
 #endif
 
 static void
@@ -197,6 +244,10 @@ ast_gc_mark(
 ) {
 	Ast ast = (Ast)p;
 
+	if(ast->cache) {
+		mark_ast_cache(ast, gc_mark);
+	}
+
 	switch(ast->type) {
 	default: {
 #	define ENUM(Name)       } break; case AST_##Name: {
@@ -214,6 +265,10 @@ ast_gc_sweep(
 ) {
 	Ast ast = (Ast)p;
 
+	if(ast->cache) {
+		drop_ast_cache(ast);
+	}
+
 	switch(ast->type) {
 	default: {
 #	define ENUM(Name)       } break; case AST_##Name: {
@@ -223,11 +278,7 @@ ast_gc_sweep(
 	}}
 
 	memset(ast, 0, sizeof(*ast));
-#ifndef NPOOL
-	p                 = gc_pfree(ast);
-	*(void const **)p = free_list;
-	free_list         = p;
-#else
+#ifdef NPOOL
 	gc_free(ast);
 #endif
 	return;
@@ -237,24 +288,17 @@ static Ast
 alloc_ast(
 	void
 ) {
-	if(gc_total_size() >= gc_threshold) {
+	if(gc_young_size() >= NURSERY_SIZE) {
 		run_gc();
 	}
 
 #ifndef NPOOL
-	void *ptr;
-	if(free_list) {
-		ptr       = (void *)free_list;
-		free_list = *(void **)ptr;
-	} else {
-		ptr = marray_alloc_back(&ast_pool, sizeof_ast);
-	}
-	Ast ast = gc_pmalloc(ptr, sizeof_ast, ast_gc_mark, ast_gc_sweep);
+	Ast ast = gc_class_malloc(ast_class);
 #else
 	Ast ast = gc_malloc(sizeof(*ast), ast_gc_mark, ast_gc_sweep);
 #endif
 	assert(ast != NULL);
-	*ast = (struct ast){ AST_Void, 0, 0, 0, {{ NULL }, { NULL }} };
+	*ast = (struct ast){ AST_Void, 0, 0, 0, 0, {{ NULL }, { NULL }} };
 	return ast;
 }
 
@@ -286,7 +330,10 @@ initialise_ast(
 	void
 ) {
 #ifndef NPOOL
-	sizeof_ast = gc_sizeof(struct ast);
+	if(!ast_class) {
+		ast_class = gc_new_class(sizeof(struct ast), ast_gc_mark, ast_gc_sweep);
+		assert(ast_class != NULL);
+	}
 #endif
 	if(!ZEN) {
 		ZEN = alloc_ast();
@@ -294,6 +341,31 @@ initialise_ast(
 		ZEN->type = AST_Zen;
 		ZEN->attr = ATTR_NoEvaluate | ATTR_NoAssign;
 		gc_push(ZEN);
+
+		for(size_t i = 0; i < 2; i++) {
+			Ast ast = alloc_ast();
+			assert(ast != NULL);
+			ast->type   = AST_Boolean;
+			ast->attr   = ATTR_NoEvaluate | ATTR_CopyOnAssign;
+			ast->m.ival = i;
+			immediate_boolean[i] = gc_push(ast);
+		}
+		for(size_t i = 0; i < IMMEDIATE_INTEGERS; i++) {
+			Ast ast = alloc_ast();
+			assert(ast != NULL);
+			ast->type   = AST_Integer;
+			ast->attr   = ATTR_NoEvaluate | ATTR_CopyOnAssign;
+			ast->m.ival = i;
+			immediate_integer[i] = gc_push(ast);
+		}
+		for(size_t i = 0; i < IMMEDIATE_CHARACTERS; i++) {
+			Ast ast = alloc_ast();
+			assert(ast != NULL);
+			ast->type   = AST_Character;
+			ast->attr   = ATTR_NoEvaluate | ATTR_CopyOnAssign;
+			ast->m.ival = i;
+			immediate_character[i] = gc_push(ast);
+		}
 	}
 }
 
@@ -331,6 +403,7 @@ new_ast_from_lexeme(
 			if(ast_isBracketed(rexpr)) {
 				if(ast_isZen(rexpr->m.lexpr)) {
 					rexpr->m.lexpr = lexpr;
+					gc_remember(rexpr);
 					va_end(va);
 					return rexpr;
 				}
@@ -340,6 +413,7 @@ new_ast_from_lexeme(
 			) {
 				if(ast_isZen(lexpr->m.rexpr)) {
 					lexpr->m.rexpr = rexpr;
+					gc_remember(lexpr);
 					va_end(va);
 					return lexpr;
 				}
@@ -439,6 +513,35 @@ new_ast(
 	return gc_push(ast);
 }
 
+Ast
+new_immediate(
+	sloc_t   sloc,
+	Type     type,
+	uint64_t ival
+) {
+	// while tracing, results keep their own source location
+	switch(trace_enabled ? AST_Zen : type) {
+	case AST_Boolean:
+		return immediate_boolean[ival != 0];
+	case AST_Integer:
+		if(ival < IMMEDIATE_INTEGERS) {
+			return immediate_integer[ival];
+		}
+		break;
+	case AST_Character:
+		if(ival < IMMEDIATE_CHARACTERS) {
+			return immediate_character[ival];
+		}
+		break;
+	default:
+		break;
+	}
+	if(type == AST_Character) {
+		return new_ast(sloc, type, (char32_t)ival);
+	}
+	return new_ast(sloc, type, ival);
+}
+
 Ast
 dup_ast(
 	sloc_t sloc,
@@ -485,3 +588,114 @@ dup_ref(
 	return dup_ast(sloc, ast);
 }
 
+//------------------------------------------------------------------------------
+
+struct spine {
+	size_t length;
+	Ast    tail;
+};
+
+static void
+release_spine(
+	void *data
+) {
+	free(data);
+}
+
+static void
+mark_spine(
+	void  *data,
+	void (*gc_mark)(void const *)
+) {
+	struct spine *spine = data;
+	gc_mark(spine->tail);
+}
+
+// The spine of a sequence is only ever extended at its tail, so a cached
+// tail cell that still ends the list means the cached length is current.
+// Evaluating a sequence copies just its head cell, so the spine is cached
+// on the second cell, which every copy shares.
+static struct spine *
+sequence_spine(
+	Ast seq
+) {
+	Ast anchor = seq->m.rexpr;
+	if(ast_isnotSequence(anchor)) {
+		return NULL;
+	}
+
+	struct spine *spine = ast_cache(anchor, CACHE_Sequence);
+
+	if(spine && ast_isnotSequence(spine->tail->m.rexpr)) {
+		return spine;
+	}
+
+	size_t length = 3;
+	Ast    tail   = anchor;
+	for(; ast_isSequence(tail->m.rexpr); tail = tail->m.rexpr) {
+		++length;
+	}
+
+	if(!spine) {
+		spine = malloc(sizeof(*spine));
+		if(!spine || !set_ast_cache(anchor, CACHE_Sequence, spine, release_spine, mark_spine)) {
+			free(spine);
+			return NULL;
+		}
+	}
+	spine->length = length;
+	spine->tail   = tail;
+	gc_remember(anchor);
+
+	return spine;
+}
+
+size_t
+sequence_length(
+	Ast seq
+) {
+	assert(ast_isSequence(seq));
+
+	struct spine *spine = sequence_spine(seq);
+	if(spine) {
+		return spine->length;
+	}
+
+	size_t length = 1;
+	for(; ast_isSequence(seq); seq = seq->m.rexpr) {
+		++length;
+	}
+	return length;
+}
+
+Ast
+sequence_append(
+	sloc_t sloc,
+	Ast    seq,
+	Ast    ast
+) {
+	assert(ast_isSequence(seq));
+
+	struct spine *spine = sequence_spine(seq);
+
+	Ast tail = seq;
+	if(spine) {
+		tail = spine->tail;
+	} else for(; ast_isSequence(tail->m.rexpr); tail = tail->m.rexpr);
+
+	if(ast_isnotZen(tail->m.rexpr)) {
+		ast           = new_ast(sloc, AST_Sequence, tail->m.rexpr, ast);
+		tail->m.rexpr = ast;
+		if(spine) {
+			spine->tail    = ast;
+			spine->length += 1;
+			gc_remember(seq->m.rexpr);
+		}
+	} else {
+		tail->m.rexpr = ast;
+	}
+	gc_remember(tail);
+
+	return seq;
+}
+
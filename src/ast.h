@@ -26,6 +26,7 @@ SOFTWARE.
 
 #include "stdtypes.h"
 #include "string.h"
+#include "strlib.h"
 #include "marray.h"
 #include "bitmac.h"
 #include "sloc.h"
@@ -81,6 +82,7 @@ struct ast {
 	Type      type : TYPE_BIT;
 	unsigned  attr : ATTR_BIT;
 	unsigned  qual : QUAL_BIT;
+	unsigned  cache;
 	sloc_t    sloc;
 	struct {
 		union {
@@ -166,6 +168,18 @@ ast_isnotDeferred(
 	return ast && ((ast->type != AST_Reference) && (ast->type != AST_Quoted));
 }
 
+// Strings are hashed on first use, as the value of a long concatenation is
+// not flattened until its characters are needed.
+static inline uint64_t
+ast_hash(
+	Ast ast
+) {
+	if(!ast->m.hash) {
+		ast->m.hash = HashString(ast->m.sval);
+	}
+	return ast->m.hash;
+}
+
 static inline bool
 ast_isOp(
 	Ast      ast,
@@ -360,6 +374,13 @@ new_ast(
 	...
 );
 
+extern Ast
+new_immediate(
+	sloc_t   sloc,
+	Type     type,
+	uint64_t ival
+);
+
 extern Ast
 dup_ast(
 	sloc_t sloc,
@@ -372,6 +393,20 @@ dup_ref(
 	Ast    ast
 );
 
+extern size_t
+sequence_length(
+	Ast seq
+);
+
+extern Ast
+sequence_append(
+	sloc_t sloc,
+	Ast    seq,
+	Ast    ast
+);
+
+extern size_t gc_step_size;
+
 extern void
 run_gc(
 	void
@@ -31,8 +31,12 @@ SOFTWARE.
 #include "hash.h"
 #include "utf8.h"
 #include "eval.h"
+#include "compile.h"
+#include "cache.h"
 #include "env.h"
 #include "odt.h"
+#include "system.h"
+#include "trace.h"
 #include "gc.h"
 #include <stdlib.h>
 #include <math.h>
@@ -296,16 +300,6 @@ ast_isLogicalAnd(
 
 #define TYPE(L,R)  (((L) << TYPE_BIT) | (R))
 
-typedef uint64_t (*IntegerOp)(uint64_t, uint64_t);
-#define INTEGEROP(Name,...) \
-	uint64_t \
-	integer_##Name( \
-		uint64_t lval, \
-		uint64_t rval  \
-	) { \
-		__VA_ARGS__; \
-	}
-
 typedef double (*FloatFn)(double);
 #define FLOATFN(Name,...) \
 	double \
@@ -315,16 +309,6 @@ typedef double (*FloatFn)(double);
 		__VA_ARGS__; \
 	}
 
-typedef double (*FloatOp)(double, double);
-#define FLOATOP(Name,...) \
-	double \
-	float_##Name( \
-		double lval, \
-		double rval  \
-	) { \
-		__VA_ARGS__; \
-	}
-
 typedef String (*StringOp)(StringConst, StringConst);
 #define STRINGOP(Name,...) \
 	String \
@@ -355,7 +339,6 @@ typedef Array (*ArrIntOp)(Array, uint64_t);
 		__VA_ARGS__; \
 	}
 
-typedef uint64_t (*IntegerCmp)(uint64_t, uint64_t);
 #define INTEGERCMP(Name,...) \
 	uint64_t \
 	integer_##Name( \
@@ -365,7 +348,6 @@ typedef uint64_t (*IntegerCmp)(uint64_t, uint64_t);
 		__VA_ARGS__; \
 	}
 
-typedef uint64_t (*FloatCmp)(double, double);
 #define FLOATCMP(Name,...) \
 	uint64_t \
 	float_##Name( \
@@ -578,7 +560,7 @@ in_range_1(
 		size_t const N   = marray_length(arr);
 
 		for(size_t i = 0; i < N; i++) {
-			expr = marray_at(arr, Ast, i);
+			expr = env_element(arr, i);
 
 			if(!in_range_1(lexpr, expr, rexpr)) {
 				return false;
@@ -636,9 +618,11 @@ builtin_if_1(
 	Ast    rexpr,
 	bool   inverted
 ) {
+	bool const tail = is_tail_operator(lexpr, rexpr);
+
 	if(ast_isZen(lexpr) || ast_isZen(rexpr)) {
 		uint64_t cond = ast_toBool(evalseq(env, ast_isnotZen(lexpr) ? lexpr : rexpr)) ^ inverted;
-		return new_ast(sloc, AST_Boolean, cond);
+		return new_immediate(sloc, AST_Boolean, cond);
 	}
 
 	for(lexpr = undefer(env, lexpr);
@@ -655,14 +639,14 @@ builtin_if_1(
 	rexpr = undefer(env, rexpr);
 	if(ast_isAssemblage(rexpr)) {
 		if(!cond) {
-			return refeval(env, rexpr->m.rexpr);
+			return tail_refeval(env, rexpr->m.rexpr, tail);
 		}
 
-		return refeval(env, rexpr->m.lexpr);
+		return tail_refeval(env, rexpr->m.lexpr, tail);
 	}
 
 	if(cond) {
-		return refeval(env, rexpr);
+		return tail_refeval(env, rexpr, tail);
 	}
 
 	return lexpr;
@@ -739,6 +723,371 @@ builtin_case_equal(
 	return are_equal(expr, cond);
 }
 
+//------------------------------------------------------------------------------
+
+// When every label of a ?: is an integer, character or string literal, or a
+// range of integer or character literals, the arm is selected through a
+// table cached on the arms: disjoint integer segments and string hashes,
+// both sorted for binary search, each mapping to the first matching arm.
+// Unlabelled expressions after the last arm are left to the linear path.
+
+struct casesegment {
+	uint64_t lo;
+	uint64_t hi;
+	size_t   arm;
+};
+
+struct casestring {
+	uint64_t hash;
+	size_t   arm;
+	String   sval;
+};
+
+struct casetable {
+	bool                usable;
+	bool                ranges;
+	size_t              narm;
+	Ast                *action;
+	Ast                 otherwise;
+	size_t              nsegment;
+	struct casesegment *segment;
+	size_t              nstring;
+	struct casestring  *string;
+};
+
+struct casebuilder {
+	struct casetable   *table;
+	size_t              ninterval;
+	size_t              capacity;
+	struct casesegment *interval;
+};
+
+static void
+release_casetable(
+	void *p
+) {
+	struct casetable *table = p;
+	free(table->action);
+	free(table->segment);
+	free(table->string);
+	free(table);
+}
+
+static bool
+is_integer_literal(
+	Ast ast
+) {
+	return (ast->attr & ATTR_NoEvaluate)
+		&& (ast_isBoolean(ast) || ast_isInteger(ast) || ast_isCharacter(ast));
+}
+
+static bool
+add_case_interval(
+	struct casebuilder *b,
+	uint64_t            lo,
+	uint64_t            hi,
+	size_t              arm
+) {
+	if(b->ninterval == b->capacity) {
+		size_t              capacity = b->capacity ? b->capacity * 2 : 16;
+		struct casesegment *p        = realloc(b->interval, capacity * sizeof(*p));
+		if(!p) {
+			return false;
+		}
+		b->interval = p;
+		b->capacity = capacity;
+	}
+
+	b->interval[b->ninterval++] = (struct casesegment){ lo, hi, arm };
+	return true;
+}
+
+static bool
+add_case_string(
+	struct casetable *table,
+	Ast               label,
+	size_t            arm
+) {
+	struct casestring *p = realloc(table->string, (table->nstring + 1) * sizeof(*p));
+	if(!p) {
+		return false;
+	}
+	table->string = p;
+	table->string[table->nstring++] = (struct casestring){ HashString(label->m.sval), arm, label->m.sval };
+	return true;
+}
+
+static bool
+add_case_labels(
+	struct casebuilder *b,
+	Ast                 expr,
+	size_t              arm
+) {
+	if(ast_isTag(expr)) {
+		if(!add_case_labels(b, expr->m.lexpr, arm)) {
+			return false;
+		}
+
+		expr = expr->m.rexpr;
+	}
+
+	if(is_integer_literal(expr)) {
+		return add_case_interval(b, expr->m.ival, expr->m.ival, arm);
+	}
+
+	if((expr->attr & ATTR_NoEvaluate) && ast_isString(expr)) {
+		return add_case_string(b->table, expr, arm);
+	}
+
+	if(ast_isRange(expr)
+		&& is_integer_literal(expr->m.lexpr)
+		&& is_integer_literal(expr->m.rexpr)
+	) {
+		uint64_t const l = expr->m.lexpr->m.ival;
+		uint64_t const r = expr->m.rexpr->m.ival;
+
+		b->table->ranges = true;
+		return (l < r) ? (
+			add_case_interval(b, l, r, arm)
+		) : (
+			add_case_interval(b, r, l, arm)
+		);
+	}
+
+	return false;
+}
+
+static int
+compare_uint64(
+	void const *l,
+	void const *r
+) {
+	uint64_t const a = *(uint64_t const *)l;
+	uint64_t const b = *(uint64_t const *)r;
+	return (a > b) - (a < b);
+}
+
+static int
+compare_casestring(
+	void const *l,
+	void const *r
+) {
+	struct casestring const *a = l;
+	struct casestring const *b = r;
+	if(a->hash != b->hash) {
+		return (a->hash > b->hash) - (a->hash < b->hash);
+	}
+	return (a->arm > b->arm) - (a->arm < b->arm);
+}
+
+// Splits the (possibly overlapping) label intervals at every boundary, and
+// gives each resulting segment the first arm that covers it.
+static bool
+build_case_segments(
+	struct casebuilder *b
+) {
+	struct casetable *table = b->table;
+	size_t            n     = b->ninterval;
+
+	if(n == 0) {
+		return true;
+	}
+
+	uint64_t *bound = malloc(2 * n * sizeof(*bound));
+	if(!bound) {
+		return false;
+	}
+
+	size_t m = 0;
+	for(size_t i = 0; i < n; i++) {
+		bound[m++] = b->interval[i].lo;
+		if(b->interval[i].hi < UINT64_MAX) {
+			bound[m++] = b->interval[i].hi + 1;
+		}
+	}
+	qsort(bound, m, sizeof(*bound), compare_uint64);
+
+	table->segment = malloc(m * sizeof(*table->segment));
+	if(!table->segment) {
+		free(bound);
+		return false;
+	}
+
+	for(size_t k = 0; k < m; k++) {
+		if((k > 0) && (bound[k] == bound[k - 1])) {
+			continue;
+		}
+
+		size_t arm = SIZE_MAX;
+		for(size_t i = 0; i < n; i++) {
+			if((b->interval[i].lo <= bound[k])
+				&& (bound[k] <= b->interval[i].hi)
+				&& (b->interval[i].arm < arm)
+			) {
+				arm = b->interval[i].arm;
+			}
+		}
+		if(arm == SIZE_MAX) {
+			continue;
+		}
+
+		uint64_t hi = UINT64_MAX;
+		for(size_t j = k + 1; j < m; j++) {
+			if(bound[j] != bound[k]) {
+				hi = bound[j] - 1;
+				break;
+			}
+		}
+
+		struct casesegment *last = table->nsegment ? &table->segment[table->nsegment - 1] : NULL;
+		if(last && (last->arm == arm) && (last->hi + 1 == bound[k])) {
+			last->hi = hi;
+		} else {
+			table->segment[table->nsegment++] = (struct casesegment){ bound[k], hi, arm };
+		}
+	}
+
+	free(bound);
+	return true;
+}
+
+static bool
+has_case_label(
+	Ast ast
+) {
+	for(; ast_isAssemblage(ast); ast = ast->m.rexpr) {
+		if(ast_isTag(ast->m.lexpr)) {
+			return true;
+		}
+	}
+	return ast_isTag(ast);
+}
+
+static struct casetable *
+build_casetable(
+	Ast arms
+) {
+	struct casetable *table = malloc(sizeof(*table));
+	if(!table) {
+		return NULL;
+	}
+	*table = (struct casetable){ false, false, 0, NULL, NULL, 0, NULL, 0, NULL };
+
+	struct casebuilder b = { table, 0, 0, NULL };
+
+	size_t n = 1;
+	for(Ast ast = arms; ast_isAssemblage(ast); ast = ast->m.rexpr) {
+		n++;
+	}
+
+	table->action = malloc(n * sizeof(*table->action));
+	if(!table->action) {
+		return table;
+	}
+
+	for(Ast ast = arms; ; ast = ast->m.rexpr) {
+		Ast arm = ast_isAssemblage(ast) ? ast->m.lexpr : ast;
+
+		if(!ast_isTag(arm)) {
+			if(has_case_label(ast)) {
+				goto done;
+			}
+			table->otherwise = ast;
+			break;
+		}
+
+		if(!add_case_labels(&b, arm->m.lexpr, table->narm)) {
+			goto done;
+		}
+		table->action[table->narm++] = arm->m.rexpr;
+
+		if(!ast_isAssemblage(ast)) {
+			break;
+		}
+	}
+
+	if(table->nstring > 0) {
+		qsort(table->string, table->nstring, sizeof(*table->string), compare_casestring);
+	}
+
+	table->usable = build_case_segments(&b);
+
+done:
+	free(b.interval);
+	return table;
+}
+
+static struct casetable const *
+casetable(
+	Ast arms
+) {
+	struct casetable *table = ast_cache(arms, CACHE_Case);
+
+	if(!table && !arms->cache) {
+		table = build_casetable(arms);
+		if(table && !set_ast_cache(arms, CACHE_Case, table, release_casetable, NULL)) {
+			release_casetable(table);
+			table = NULL;
+		}
+	}
+
+	return (table && table->usable) ? table : NULL;
+}
+
+static size_t
+case_select(
+	struct casetable const *table,
+	Ast                     cond
+) {
+	switch(ast_type(cond)) {
+	case AST_Boolean:
+	case AST_Integer:
+	case AST_Character: {
+			uint64_t const v  = cond->m.ival;
+			size_t         lo = 0;
+			size_t         hi = table->nsegment;
+			while(lo < hi) {
+				size_t const mid = lo + ((hi - lo) / 2);
+				if(table->segment[mid].hi < v) {
+					lo = mid + 1;
+				} else {
+					hi = mid;
+				}
+			}
+			if((lo < table->nsegment) && (table->segment[lo].lo <= v)) {
+				return table->segment[lo].arm;
+			}
+			return table->narm;
+		}
+	case AST_String: {
+			if(table->ranges) {
+				break;
+			}
+			uint64_t const h  = HashString(cond->m.sval);
+			size_t         lo = 0;
+			size_t         hi = table->nstring;
+			while(lo < hi) {
+				size_t const mid = lo + ((hi - lo) / 2);
+				if(table->string[mid].hash < h) {
+					lo = mid + 1;
+				} else {
+					hi = mid;
+				}
+			}
+			for(; (lo < table->nstring) && (table->string[lo].hash == h); lo++) {
+				if(StringEqual(table->string[lo].sval, cond->m.sval)) {
+					return table->string[lo].arm;
+				}
+			}
+			return table->narm;
+		}
+	default:
+		break;
+	}
+
+	return ~SIZE_C(0);
+}
+
 static Ast
 builtin_case(
 	Ast    env,
@@ -746,6 +1095,8 @@ builtin_case(
 	Ast    lexpr,
 	Ast    rexpr
 ) {
+	bool const tail = is_tail_operator(lexpr, rexpr);
+
 	for(lexpr = undefer(env, lexpr);
 		ast_isAssemblage(lexpr);
 		lexpr = lexpr->m.rexpr
@@ -762,7 +1113,7 @@ builtin_case(
 
 			if(ast_isTag(lexpr)) {
 				if(builtin_case_match(env, lexpr->m.lexpr)) {
-					return refeval(env, lexpr->m.rexpr);
+					return tail_refeval(env, lexpr->m.rexpr, tail);
 				}
 				continue;
 			}
@@ -772,7 +1123,7 @@ builtin_case(
 
 		if(ast_isTag(rexpr)) {
 			if(builtin_case_match(env, rexpr->m.lexpr)) {
-				return refeval(env, rexpr->m.rexpr);
+				return tail_refeval(env, rexpr->m.rexpr, tail);
 			}
 			return ZEN;
 		}
@@ -780,7 +1131,24 @@ builtin_case(
 	} else {
 		Ast cond = evalseq(env, lexpr);
 
-		for(rexpr = undefer(env, rexpr);
+		rexpr = undefer(env, rexpr);
+		if(ast_isAssemblage(rexpr) && !trace_enabled) {
+			struct casetable const *table = casetable(rexpr);
+			if(table) {
+				size_t const arm = case_select(table, cond);
+				if(arm < table->narm) {
+					return tail_refeval(env, table->action[arm], tail);
+				}
+				if(arm == table->narm) {
+					if(!table->otherwise) {
+						return ZEN;
+					}
+					rexpr = table->otherwise;
+				}
+			}
+		}
+
+		for(;
 			ast_isAssemblage(rexpr);
 			rexpr = rexpr->m.rexpr
 		) {
@@ -788,7 +1156,7 @@ builtin_case(
 
 			if(ast_isTag(lexpr)) {
 				if(builtin_case_equal(env, lexpr->m.lexpr, cond)) {
-					return refeval(env, lexpr->m.rexpr);
+					return tail_refeval(env, lexpr->m.rexpr, tail);
 				}
 				continue;
 			}
@@ -798,13 +1166,13 @@ builtin_case(
 
 		if(ast_isTag(rexpr)) {
 			if(builtin_case_equal(env, rexpr->m.lexpr, cond)) {
-				return refeval(env, rexpr->m.rexpr);
+				return tail_refeval(env, rexpr->m.rexpr, tail);
 			}
 			return ZEN;
 		}
 	}
 
-	return refeval(env, rexpr);
+	return tail_refeval(env, rexpr, tail);
 	(void)sloc;
 }
 
@@ -889,7 +1257,9 @@ builtin_loop_array(
 			size_t ts = gc_topof_stack();
 
 			if(ast_isZen(bexpr)) for(;;) {
+				unshare_env(arr);
 				texpr->m.rexpr = marray_at(arr, Ast, index);
+				gc_remember(texpr);
 
 				result = refeval(env, rexpr);
 
@@ -902,7 +1272,9 @@ builtin_loop_array(
 				index += step;
 			}
 			else for(;;) {
+				unshare_env(arr);
 				texpr->m.rexpr = marray_at(arr, Ast, index);
+				gc_remember(texpr);
 
 				if(!ast_toBool(eval(env, bexpr))) break;
 
@@ -955,6 +1327,7 @@ builtin_loop_range(
 
 		if(ast_isZen(bexpr)) for(;;) {
 			texpr->m.rexpr = iexpr;
+			gc_remember(texpr);
 
 			result = refeval(env, rexpr);
 
@@ -967,6 +1340,7 @@ builtin_loop_range(
 		}
 		else for(;;) {
 			texpr->m.rexpr = iexpr;
+			gc_remember(texpr);
 
 			if(!ast_toBool(eval(env, bexpr))) break;
 
@@ -1011,6 +1385,7 @@ builtin_loop_sequence(
 		if(ast_isZen(bexpr)) {
 			do {
 				texpr->m.rexpr = iexpr->m.lexpr;
+				gc_remember(texpr);
 
 				result = refeval(env, rexpr);
 
@@ -1021,6 +1396,7 @@ builtin_loop_sequence(
 				;
 			if(ast_isnotZen(iexpr)) {
 				texpr->m.rexpr = iexpr;
+				gc_remember(texpr);
 
 				result = refeval(env, rexpr);
 
@@ -1030,6 +1406,7 @@ builtin_loop_sequence(
 			bool b = true;
 			do {
 				texpr->m.rexpr = iexpr->m.lexpr;
+				gc_remember(texpr);
 
 				b = ast_toBool(eval(env, bexpr));
 				if(!b) break;
@@ -1043,6 +1420,7 @@ builtin_loop_sequence(
 				;
 			if(b && ast_isnotZen(iexpr)) {
 				texpr->m.rexpr = iexpr;
+				gc_remember(texpr);
 
 				if(ast_toBool(eval(env, bexpr))) {
 					result = refeval(env, rexpr);
@@ -1202,7 +1580,7 @@ builtin_land(
 		result = ast_toBool(rexpr);
 	}
 
-	return new_ast(sloc, AST_Boolean, result);
+	return new_immediate(sloc, AST_Boolean, result);
 }
 
 static Ast
@@ -1221,93 +1599,20 @@ builtin_lor(
 		result = ast_toBool(rexpr);
 	}
 
-	return new_ast(sloc, AST_Boolean, result);
+	return new_immediate(sloc, AST_Boolean, result);
 }
 
 //------------------------------------------------------------------------------
 
 static int
-compare_delegate(
-	Ast        env,
-	sloc_t     sloc,
+compare_values(
 	Ast        lexpr,
 	Ast        rexpr,
 	IntegerCmp integercmp,
 	FloatCmp   floatcmp,
-	StringCmp  stringcmp,
-	int        sense
+	StringCmp  stringcmp
 ) {
-	lexpr = eval(env, lexpr);
-	rexpr = eval(env, rexpr);
-
-	if(ast_isEnvironment(lexpr) || ast_isEnvironment(rexpr)) {
-		if(ast_isEnvironment(lexpr) && ast_isEnvironment(rexpr)) {
-			size_t const ln = marray_length(lexpr->m.env);
-			size_t const rn = marray_length(rexpr->m.env);
-			size_t const n = minz(ln, rn);
-			int          r = 1;
-			for(size_t i = 0; r > 0 && i < n; i++) {
-				r = compare_delegate(env, sloc,
-						marray_at(lexpr->m.env, Ast, i),
-						marray_at(rexpr->m.env, Ast, i),
-						integercmp,
-						floatcmp,
-						stringcmp,
-						sense
-					);
-			}
-			for(size_t i = n; r == sense && i < ln; i++) {
-				r = compare_delegate(env, sloc,
-						marray_at(lexpr->m.env, Ast, i),
-						ZEN,
-						integercmp,
-						floatcmp,
-						stringcmp,
-						sense
-					);
-			}
-			for(size_t i = n; r == sense && i < rn; i++) {
-				r = compare_delegate(env, sloc,
-						ZEN,
-						marray_at(rexpr->m.env, Ast, i),
-						integercmp,
-						floatcmp,
-						stringcmp,
-						sense
-					);
-			}
-			return r;
-		} else if(ast_isEnvironment(lexpr)) {
-			size_t const n = marray_length(lexpr->m.env);
-			int          r = 1;
-			for(size_t i = 0; r > 0 && i < n; i++) {
-				r = compare_delegate(env, sloc,
-						marray_at(lexpr->m.env, Ast, i),
-						rexpr,
-						integercmp,
-						floatcmp,
-						stringcmp,
-						sense
-					);
-			}
-			return r;
-		} else {
-			size_t const n = marray_length(rexpr->m.env);
-			int          r = 1;
-			for(size_t i = 0; r > 0 && i < n; i++) {
-				r = compare_delegate(env, sloc,
-						lexpr,
-						marray_at(rexpr->m.env, Ast, i),
-						integercmp,
-						floatcmp,
-						stringcmp,
-						sense
-					);
-			}
-			return r;
-		}
-
-	} else switch(TYPE(ast_type(lexpr), ast_type(rexpr))) {
+	switch(TYPE(ast_type(lexpr), ast_type(rexpr))) {
 	case TYPE(AST_Boolean  , AST_Boolean):
 	case TYPE(AST_Boolean  , AST_Integer):
 	case TYPE(AST_Boolean  , AST_Character):
@@ -1353,6 +1658,140 @@ compare_delegate(
 	}
 }
 
+struct compare_frame {
+	Ast    lexpr;
+	Ast    rexpr;
+	size_t n;
+	size_t i;
+	int    phase;
+	int    r;
+};
+
+struct compare_stack {
+	struct compare_frame *base;
+	size_t                length;
+	size_t                capacity;
+};
+
+static struct compare_frame *
+push_compare_frame(
+	struct compare_stack *stack,
+	Ast                   lexpr,
+	Ast                   rexpr
+) {
+	if(stack->length == stack->capacity) {
+		size_t                capacity = stack->capacity ? stack->capacity * 2 : 16;
+		struct compare_frame *p        = realloc(stack->base, capacity * sizeof(*p));
+		if(!p) {
+			return NULL;
+		}
+		stack->base     = p;
+		stack->capacity = capacity;
+	}
+
+	size_t const ln = ast_isEnvironment(lexpr) ? marray_length(lexpr->m.env) : SIZE_MAX;
+	size_t const rn = ast_isEnvironment(rexpr) ? marray_length(rexpr->m.env) : SIZE_MAX;
+
+	struct compare_frame *frame = &stack->base[stack->length++];
+	*frame = (struct compare_frame){ lexpr, rexpr, minz(ln, rn), 0, 0, 1 };
+	return frame;
+}
+
+// Selects the next pair of elements to compare, or returns false once the
+// frame is complete; mirrors the element loops of the recursive definition.
+static bool
+next_compare_pair(
+	struct compare_frame *frame,
+	int                   sense,
+	Ast                  *lexpr,
+	Ast                  *rexpr
+) {
+	Ast const l = frame->lexpr;
+	Ast const r = frame->rexpr;
+
+	switch(frame->phase) {
+	case 0:
+		if((frame->i < frame->n) && (frame->r > 0)) {
+			*lexpr = ast_isEnvironment(l) ? env_element(l->m.env, frame->i) : l;
+			*rexpr = ast_isEnvironment(r) ? env_element(r->m.env, frame->i) : r;
+			frame->i++;
+			return true;
+		}
+		if(!ast_isEnvironment(l) || !ast_isEnvironment(r)) {
+			return false;
+		}
+		frame->phase = 1;
+		frame->i     = frame->n;
+		nobreak;
+	case 1:
+		if((frame->i < marray_length(l->m.env)) && (frame->r == sense)) {
+			*lexpr = env_element(l->m.env, frame->i);
+			*rexpr = ZEN;
+			frame->i++;
+			return true;
+		}
+		frame->phase = 2;
+		frame->i     = frame->n;
+		nobreak;
+	case 2:
+		if((frame->i < marray_length(r->m.env)) && (frame->r == sense)) {
+			*lexpr = ZEN;
+			*rexpr = env_element(r->m.env, frame->i);
+			frame->i++;
+			return true;
+		}
+		nobreak;
+	default:
+		return false;
+	}
+}
+
+static int
+compare_delegate(
+	Ast        env,
+	sloc_t     sloc,
+	Ast        lexpr,
+	Ast        rexpr,
+	IntegerCmp integercmp,
+	FloatCmp   floatcmp,
+	StringCmp  stringcmp,
+	int        sense
+) {
+	struct compare_stack stack = { NULL, 0, 0 };
+	int                  r;
+
+	for(;;) {
+		lexpr = eval(env, lexpr);
+		rexpr = eval(env, rexpr);
+
+		if(ast_isEnvironment(lexpr) || ast_isEnvironment(rexpr)) {
+			if(!push_compare_frame(&stack, lexpr, rexpr)) {
+				r = -1;
+				break;
+			}
+		} else {
+			r = compare_values(lexpr, rexpr, integercmp, floatcmp, stringcmp);
+			if(stack.length == 0) {
+				break;
+			}
+			stack.base[stack.length - 1].r = r;
+		}
+
+		while(!next_compare_pair(&stack.base[stack.length - 1], sense, &lexpr, &rexpr)) {
+			r = stack.base[--stack.length].r;
+			if(stack.length == 0) {
+				goto done;
+			}
+			stack.base[stack.length - 1].r = r;
+		}
+	}
+
+done:
+	free(stack.base);
+	return r;
+	(void)sloc;
+}
+
 static Ast
 builtin_compare(
 	Ast        env,
@@ -1370,7 +1809,7 @@ builtin_compare(
 		sense
 	);
 	if(r >= 0) {
-		return new_ast(sloc, AST_Boolean, (uint64_t)(r != 0));
+		return new_immediate(sloc, AST_Boolean, (uint64_t)(r != 0));
 	}
 
 	return oboerr(sloc, ERR_InvalidOperand);
@@ -1415,6 +1854,20 @@ static BUILTIN_COMPARE(neq, 0)
 static BUILTIN_COMPARE(gte, 1)
 static BUILTIN_COMPARE(gt, 0)
 
+int
+compare_less(
+	Ast    env,
+	sloc_t sloc,
+	Ast    lexpr,
+	Ast    rexpr
+) {
+	return compare_delegate(env, sloc,
+		lexpr, rexpr,
+		integer_lt, float_lt, string_lt,
+		0
+	);
+}
+
 //------------------------------------------------------------------------------
 
 static Ast
@@ -1423,7 +1876,8 @@ builtin_bitwise(
 	sloc_t    sloc,
 	Ast       lexpr,
 	Ast       rexpr,
-	IntegerOp integerop
+	IntegerOp integerop,
+	VectorOp  vectorop
 ) {
 	lexpr = eval(env, lexpr);
 	rexpr = eval(env, rexpr);
@@ -1438,30 +1892,33 @@ builtin_bitwise(
 	case TYPE(AST_Character, AST_Boolean):
 	case TYPE(AST_Character, AST_Integer):
 	case TYPE(AST_Character, AST_Character):
-		return new_ast(sloc, AST_Integer, integerop(lexpr->m.ival, rexpr->m.ival));
+		return new_immediate(sloc, AST_Integer, integerop(lexpr->m.ival, rexpr->m.ival));
 	case TYPE(AST_Boolean, AST_Float):
 	case TYPE(AST_Integer, AST_Float):
 	case TYPE(AST_Character, AST_Float):
-		return new_ast(sloc, AST_Integer, integerop(lexpr->m.ival, double_to_uint64_t(rexpr->m.fval)));
+		return new_immediate(sloc, AST_Integer, integerop(lexpr->m.ival, double_to_uint64_t(rexpr->m.fval)));
 	case TYPE(AST_Float, AST_Boolean):
 	case TYPE(AST_Float, AST_Integer):
 	case TYPE(AST_Float, AST_Character):
-		return new_ast(sloc, AST_Integer, integerop(double_to_uint64_t(lexpr->m.fval), rexpr->m.ival));
+		return new_immediate(sloc, AST_Integer, integerop(double_to_uint64_t(lexpr->m.fval), rexpr->m.ival));
 	case TYPE(AST_Float, AST_Float):
-		return new_ast(sloc, AST_Integer, integerop(double_to_uint64_t(lexpr->m.fval), double_to_uint64_t(rexpr->m.fval)));
+		return new_immediate(sloc, AST_Integer, integerop(double_to_uint64_t(lexpr->m.fval), double_to_uint64_t(rexpr->m.fval)));
 	case TYPE(AST_Boolean, AST_Zen):
 	case TYPE(AST_Integer, AST_Zen):
 	case TYPE(AST_Character, AST_Zen):
-		return new_ast(sloc, AST_Integer, integerop(lexpr->m.ival, 0));
+		return new_immediate(sloc, AST_Integer, integerop(lexpr->m.ival, 0));
 	case TYPE(AST_Float, AST_Zen):
-		return new_ast(sloc, AST_Integer, integerop(double_to_uint64_t(lexpr->m.fval), 0));
+		return new_immediate(sloc, AST_Integer, integerop(double_to_uint64_t(lexpr->m.fval), 0));
 	case TYPE(AST_Zen, AST_Boolean):
 	case TYPE(AST_Zen, AST_Integer):
 	case TYPE(AST_Zen, AST_Character):
-		return new_ast(sloc, AST_Integer, integerop(0, rexpr->m.ival));
+		return new_immediate(sloc, AST_Integer, integerop(0, rexpr->m.ival));
 	case TYPE(AST_Zen, AST_Float):
-		return new_ast(sloc, AST_Integer, integerop(0, double_to_uint64_t(rexpr->m.fval)));
+		return new_immediate(sloc, AST_Integer, integerop(0, double_to_uint64_t(rexpr->m.fval)));
 	default:
+		if(ast_isVector(lexpr) || ast_isVector(rexpr)) {
+			return vector_operate(sloc, lexpr, rexpr, vectorop);
+		}
 		return invalid_operand(sloc, lexpr, rexpr);
 	}
 }
@@ -1473,13 +1930,9 @@ builtin_##Name( \
 	Ast    lexpr, \
 	Ast    rexpr  \
 ) { \
-	return builtin_bitwise(env, sloc, lexpr, rexpr, integer_##Name); \
+	return builtin_bitwise(env, sloc, lexpr, rexpr, integer_##Name, VECTOR_##Name); \
 }
 
-static INTEGEROP(and, return lval & rval)
-static INTEGEROP(or , return lval | rval)
-static INTEGEROP(xor, return lval ^ rval)
-
 static BUILTIN_BITWISE(and)
 static BUILTIN_BITWISE(or)
 static BUILTIN_BITWISE(xor)
@@ -1493,7 +1946,8 @@ builtin_arithmetic(
 	Ast       lexpr,
 	Ast       rexpr,
 	IntegerOp integerop,
-	FloatOp   floatop
+	FloatOp   floatop,
+	VectorOp  vectorop
 ) {
 	lexpr = eval(env, lexpr);
 	rexpr = eval(env, rexpr);
@@ -1508,7 +1962,7 @@ builtin_arithmetic(
 	case TYPE(AST_Character, AST_Boolean):
 	case TYPE(AST_Character, AST_Integer):
 	case TYPE(AST_Character, AST_Character):
-		return new_ast(sloc, AST_Integer, integerop(lexpr->m.ival, rexpr->m.ival));
+		return new_immediate(sloc, AST_Integer, integerop(lexpr->m.ival, rexpr->m.ival));
 	case TYPE(AST_Boolean, AST_Float):
 	case TYPE(AST_Integer, AST_Float):
 	case TYPE(AST_Character, AST_Float):
@@ -1522,16 +1976,19 @@ builtin_arithmetic(
 	case TYPE(AST_Boolean, AST_Zen):
 	case TYPE(AST_Integer, AST_Zen):
 	case TYPE(AST_Character, AST_Zen):
-		return new_ast(sloc, AST_Integer, integerop(lexpr->m.ival, 0));
+		return new_immediate(sloc, AST_Integer, integerop(lexpr->m.ival, 0));
 	case TYPE(AST_Float, AST_Zen):
 		return new_ast(sloc, AST_Float, floatop(lexpr->m.fval, 0.0));
 	case TYPE(AST_Zen, AST_Boolean):
 	case TYPE(AST_Zen, AST_Integer):
 	case TYPE(AST_Zen, AST_Character):
-		return new_ast(sloc, AST_Integer, integerop(0, rexpr->m.ival));
+		return new_immediate(sloc, AST_Integer, integerop(0, rexpr->m.ival));
 	case TYPE(AST_Zen, AST_Float):
 		return new_ast(sloc, AST_Float, floatop(0.0, rexpr->m.fval));
 	default:
+		if(ast_isVector(lexpr) || ast_isVector(rexpr)) {
+			return vector_operate(sloc, lexpr, rexpr, vectorop);
+		}
 		return invalid_operand(sloc, lexpr, rexpr);
 	}
 }
@@ -1543,21 +2000,9 @@ builtin_##Name( \
 	Ast    lexpr, \
 	Ast    rexpr  \
 ) { \
-	return builtin_arithmetic(env, sloc, lexpr, rexpr, integer_##Name, float_##Name); \
+	return builtin_arithmetic(env, sloc, lexpr, rexpr, integer_##Name, float_##Name, VECTOR_##Name); \
 }
 
-static INTEGEROP(add, return lval + rval)
-static INTEGEROP(sub, return lval - rval)
-static INTEGEROP(mul, return lval * rval)
-static INTEGEROP(div, return (rval != 0) ? lval / rval : 0)
-static INTEGEROP(mod, return (rval != 0) ? lval % rval : 0)
-
-static FLOATOP(add, return !isunordered(lval, rval) ? lval + rval : 0.0)
-static FLOATOP(sub, return !isunordered(lval, rval) ? lval - rval : 0.0)
-static FLOATOP(mul, return !isunordered(lval, rval) ? lval * rval : 0.0)
-static FLOATOP(div, return !isunordered(lval, rval) ? (islessgreater(rval, 0.0) ? lval / rval : 0.0) : 0.0)
-static FLOATOP(mod, return !isunordered(lval, rval) ? (islessgreater(rval, 0.0) ? fmod(lval, rval) : 0.0) : 0.0)
-
 static BUILTIN_ARITHMETIC(add)
 static BUILTIN_ARITHMETIC(sub)
 static BUILTIN_ARITHMETIC(mul)
@@ -1574,7 +2019,8 @@ builtin_bitmove(
 	Ast       rexpr,
 	IntegerOp integerop,
 	StrIntOp  stringop,
-	ArrIntOp  arrayop
+	ArrIntOp  arrayop,
+	VectorOp  vectorop
 ) {
 	lexpr = eval(env, lexpr);
 	rexpr = eval(env, rexpr);
@@ -1589,17 +2035,17 @@ builtin_bitmove(
 	case TYPE(AST_Character, AST_Boolean):
 	case TYPE(AST_Character, AST_Integer):
 	case TYPE(AST_Character, AST_Character):
-		return new_ast(sloc, AST_Integer, integerop(lexpr->m.ival, rexpr->m.ival));
+		return new_immediate(sloc, AST_Integer, integerop(lexpr->m.ival, rexpr->m.ival));
 	case TYPE(AST_Boolean, AST_Float):
 	case TYPE(AST_Integer, AST_Float):
 	case TYPE(AST_Character, AST_Float):
-		return new_ast(sloc, AST_Integer, integerop(lexpr->m.ival, (uint64_t)rexpr->m.fval));
+		return new_immediate(sloc, AST_Integer, integerop(lexpr->m.ival, (uint64_t)rexpr->m.fval));
 	case TYPE(AST_Float, AST_Boolean):
 	case TYPE(AST_Float, AST_Integer):
 	case TYPE(AST_Float, AST_Character):
-		return new_ast(sloc, AST_Integer, integerop(double_to_uint64_t(lexpr->m.fval), rexpr->m.ival));
+		return new_immediate(sloc, AST_Integer, integerop(double_to_uint64_t(lexpr->m.fval), rexpr->m.ival));
 	case TYPE(AST_Float, AST_Float):
-		return new_ast(sloc, AST_Integer, integerop(double_to_uint64_t(lexpr->m.fval), (uint64_t)rexpr->m.fval));
+		return new_immediate(sloc, AST_Integer, integerop(double_to_uint64_t(lexpr->m.fval), (uint64_t)rexpr->m.fval));
 	case TYPE(AST_String, AST_Boolean):
 	case TYPE(AST_String, AST_Integer):
 	case TYPE(AST_String, AST_Character):
@@ -1615,18 +2061,21 @@ builtin_bitmove(
 	case TYPE(AST_Boolean, AST_Zen):
 	case TYPE(AST_Integer, AST_Zen):
 	case TYPE(AST_Character, AST_Zen):
-		return new_ast(sloc, AST_Integer, integerop(lexpr->m.ival, 0));
+		return new_immediate(sloc, AST_Integer, integerop(lexpr->m.ival, 0));
 	case TYPE(AST_Float, AST_Zen):
-		return new_ast(sloc, AST_Integer, integerop(double_to_uint64_t(lexpr->m.fval), 0));
+		return new_immediate(sloc, AST_Integer, integerop(double_to_uint64_t(lexpr->m.fval), 0));
 	case TYPE(AST_String, AST_Zen):
 		return new_ast(sloc, AST_String , stringop(lexpr->m.sval, 0));
 	case TYPE(AST_Zen, AST_Boolean):
 	case TYPE(AST_Zen, AST_Integer):
 	case TYPE(AST_Zen, AST_Character):
-		return new_ast(sloc, AST_Integer, integerop(0, rexpr->m.ival));
+		return new_immediate(sloc, AST_Integer, integerop(0, rexpr->m.ival));
 	case TYPE(AST_Zen, AST_Float):
-		return new_ast(sloc, AST_Integer, integerop(0, (uint64_t)rexpr->m.fval));
+		return new_immediate(sloc, AST_Integer, integerop(0, (uint64_t)rexpr->m.fval));
 	default:
+		if(ast_isVector(lexpr) || ast_isVector(rexpr)) {
+			return vector_operate(sloc, lexpr, rexpr, vectorop);
+		}
 		return invalid_operand(sloc, lexpr, rexpr);
 	}
 }
@@ -1638,161 +2087,72 @@ builtin_##Name( \
 	Ast    lexpr, \
 	Ast    rexpr  \
 ) { \
-	return builtin_bitmove(env, sloc, lexpr, rexpr, integer_##Name, string_##Name, array_##Name); \
+	return builtin_bitmove(env, sloc, lexpr, rexpr, integer_##Name, string_##Name, array_##Name, VECTOR_##Name); \
 }
 
-static INTEGEROP(shl, rval &= 63; return lval << rval)
-static INTEGEROP(shr, rval &= 63; return lval >> rval)
-static INTEGEROP(exl, rval &= 63; return lval >> (64 - rval))
-static INTEGEROP(exr, rval &= 63; return lval  & (UINT64_C(~0) >> (64 - rval)))
-static INTEGEROP(rol, rval &= 63; return (lval << rval) | (lval >> (64 - rval)))
-static INTEGEROP(ror, rval &= 63; return (lval << (64 - rval)) | (lval >> rval))
-
 static STRINTOP (shl,
 	size_t      n;
 	char const *cs = StringToCharLiteral(lval, &n);
-	rval = codepointoffset(cs, n, rval);
+	rval = codepointoffset(lval, rval);
 	return CharLiteralToString(cs + rval, n - rval);
 )
 static STRINTOP (shr,
 	size_t      n;
 	char const *cs = StringToCharLiteral(lval, &n);
-	rval = reversecodepointoffset(cs, n, rval);
+	rval = reversecodepointoffset(lval, rval);
 	return CharLiteralToString(cs, rval);
 )
 static STRINTOP (exl,
 	size_t      n;
 	char const *cs = StringToCharLiteral(lval, &n);
-	rval = codepointoffset(cs, n, rval);
+	rval = codepointoffset(lval, rval);
 	return CharLiteralToString(cs, rval);
 )
 static STRINTOP (exr,
 	size_t      n;
 	char const *cs = StringToCharLiteral(lval, &n);
-	rval = reversecodepointoffset(cs, n, rval);
+	rval = reversecodepointoffset(lval, rval);
 	return CharLiteralToString(cs + rval, n - rval);
 )
 static STRINTOP (rol,
 	size_t      n;
 	char const *cs = StringToCharLiteral(lval, &n);
-	rval = codepointoffset(cs, n, rval);
+	rval = codepointoffset(lval, rval);
 	return CharLiteralsToString(cs + rval, n - rval, cs, rval);
 )
 static STRINTOP (ror,
 	size_t      n;
 	char const *cs = StringToCharLiteral(lval, &n);
-	rval = reversecodepointoffset(cs, n, rval);
+	rval = reversecodepointoffset(lval, rval);
 	return CharLiteralsToString(cs + rval, n - rval, cs, rval);
 )
 
-static inline Array
-arrintop_alloc(
-	void
-) {
-	Array arr = gc_malloc(sizeof(*arr), env_gc_mark, env_gc_sweep);
-	assert(arr != NULL);
-	*arr = ARRAY();
-	return arr;
-}
-static inline void
-arrintop_resize(
-	Array arr,
-	size_t n
-) {
-	bool   expanded = marray_expand(arr, sizeof(Ast), n);
-	assert(expanded);
-	arr->length = n;
-	return;
-}
-static inline void
-arrintop_copy(
-	Array  t,
-	size_t ti,
-	Array  s,
-	size_t si,
-	size_t n
-) {
-	for(; n-- > 0; si++, ti++) {
-		Ast st = marray_at(s, Ast, si);
-		st     = dup_ast(st->sloc, st);
-		marray_at(t, Ast, ti) = st;
-		if(ast_isReference(st)) {
-			size_t      len;
-			char const *cs = StringToCharLiteral(st->m.sval, &len);
-			uint64_t    h  = memhash(cs, len, 0);
-			size_t      x  = marray_map_index(t, h, ti);
-			assert(x == ti);
-		}
-	}
-
-	return;
-}
 static ARRINTOP (shl,
-	Array arr = arrintop_alloc();
-	if(marray_length(lval) > rval) {
-		size_t n = (marray_length(lval) - rval);
-		arrintop_resize(arr, n);
-		arrintop_copy(arr, 0, lval, rval, n);
-	}
-	return arr;
+	size_t const n = marray_length(lval);
+	return (n > rval) ? window_env(lval, rval, n - rval) : alloc_env();
 )
 static ARRINTOP (shr,
-	Array arr = arrintop_alloc();
-	if(marray_length(lval) > rval) {
-		size_t n = (marray_length(lval) - rval);
-		arrintop_resize(arr, n);
-		arrintop_copy(arr, 0, lval, 0, n);
-	}
-	return arr;
+	size_t const n = marray_length(lval);
+	return (n > rval) ? window_env(lval, 0, n - rval) : alloc_env();
 )
 static ARRINTOP (exl,
-	Array arr = arrintop_alloc();
-	if(rval > marray_length(lval)) {
-		rval = marray_length(lval);
-	}
-	if(marray_length(lval) >= rval) {
-		arrintop_resize(arr, rval);
-		arrintop_copy(arr, 0, lval, 0, rval);
-	}
-	return arr;
+	size_t const n = marray_length(lval);
+	return window_env(lval, 0, minz(rval, n));
 )
 static ARRINTOP (exr,
-	Array arr = arrintop_alloc();
-	if(rval > marray_length(lval)) {
-		rval = marray_length(lval);
-	}
-	if(marray_length(lval) >= rval) {
-		size_t n = (marray_length(lval) - rval);
-		arrintop_resize(arr, rval);
-		arrintop_copy(arr, 0, lval, n, rval);
+	size_t const n = marray_length(lval);
+	if(rval > n) {
+		rval = n;
 	}
-	return arr;
+	return window_env(lval, n - rval, rval);
 )
 static ARRINTOP (rol,
-	Array arr = arrintop_alloc();
-	if(marray_length(lval) > 0) {
-		rval = rval % marray_length(lval);
-	}
-	if(marray_length(lval) > rval) {
-		size_t n = (marray_length(lval) - rval);
-		arrintop_resize(arr, marray_length(lval));
-		arrintop_copy(arr, 0, lval, rval, n);
-		arrintop_copy(arr, n, lval, 0, rval);
-	}
-	return arr;
+	size_t const n = marray_length(lval);
+	return (n > 0) ? window_env(lval, rval % n, n) : alloc_env();
 )
 static ARRINTOP (ror,
-	Array arr = arrintop_alloc();
-	if(marray_length(lval) > 0) {
-		rval = rval % marray_length(lval);
-	}
-	if(marray_length(lval) > rval) {
-		size_t n = (marray_length(lval) - rval);
-		arrintop_resize(arr, marray_length(lval));
-		arrintop_copy(arr, 0, lval, n, rval);
-		arrintop_copy(arr, rval, lval, 0, n);
-	}
-	return arr;
+	size_t const n = marray_length(lval);
+	return (n > 0) ? window_env(lval, n - (rval % n), n) : alloc_env();
 )
 
 static BUILTIN_BITMOVE(shl)
@@ -2009,7 +2369,7 @@ builtin_decl(
 			char const *cs    = StringToCharLiteral(lexpr->m.lexpr->m.lexpr->m.sval, &len);
 			Precedence  prec  = precedence(cs, len);
 			String      s     = lexpr->m.lexpr->m.rexpr->m.sval;
-			uint64_t    hash  = lexpr->m.lexpr->m.rexpr->m.hash;
+			uint64_t    hash  = ast_hash(lexpr->m.lexpr->m.rexpr);
 			rexpr             = new_ast(sloc, AST_Function, lexpr->m.rexpr, rexpr);
 			rexpr             = new_ast(sloc, AST_OperatorFunction, s, rexpr, prec);
 			size_t      index = define(operators, hash, rexpr, (is_const ? ATTR_NoAssign : 0));
@@ -2021,7 +2381,7 @@ builtin_decl(
 			&& ast_isParameters(lexpr->m.rexpr)
 		) {
 			String      s     = lexpr->m.lexpr->m.sval;
-			uint64_t    hash  = lexpr->m.lexpr->m.hash;
+			uint64_t    hash  = ast_hash(lexpr->m.lexpr);
 			rexpr             = new_ast(sloc, AST_Function, lexpr->m.rexpr, rexpr);
 			rexpr             = new_ast(sloc, AST_OperatorFunction, s, rexpr, P_Assigning);
 			size_t      index = define(operators, hash, rexpr, ATTR_NoAssign);
@@ -2055,7 +2415,7 @@ builtin_decl(
 		return rexpr;
 	case AST_String: // for OperatorAlias
 		if(ast_isString(rexpr)) {
-			rexpr = operator_alias(operators, sloc, lexpr->m.sval, lexpr->m.hash, rexpr);
+			rexpr = operator_alias(operators, sloc, lexpr->m.sval, ast_hash(lexpr), rexpr);
 			return rexpr;
 		}
 		nobreak;
@@ -2144,7 +2504,8 @@ builtin_array_push_back(
 
 	} else {
 		rexpr = evaluate_instance(env, sloc, rexpr, by);
-		bool appended = marray_push_back(lexpr->m.env, Ast, rexpr);
+		unshare_env(lexpr->m.env);
+		bool appended = marray_push_back(lexpr->m.env, Ast, gc_remember(rexpr));
 		assert(appended);
 		return rexpr;
 	}
@@ -2161,10 +2522,11 @@ builtin_array_assign_index(
 	size_t index,
 	By     by
 ) {
-	Ast *ent = marray_ptr(lexpr->m.env, Ast, index);
-
 	rexpr = evaluate_instance(env, sloc, rexpr, by);
-	lexpr = *ent;
+	unshare_env(lexpr->m.env);
+
+	Ast *ent = marray_ptr(lexpr->m.env, Ast, index);
+	lexpr    = *ent;
 	if(ast_isReference(lexpr)) {
 		if(!ast_isAssignable(lexpr)) {
 			return oboerr(sloc, ERR_InvalidReferent);
@@ -2206,6 +2568,12 @@ builtin_referent_assign(
 
 	if(ast_isnotZen(lexpr->m.rexpr)) {
 		if(ast_isAssignable(lexpr->m.rexpr)) {
+			if((by == BY_Value) && rexpr && rexpr->cache && !trace_enabled) {
+				Ast result = execute_into(env, rexpr, sloc, lexpr->m.rexpr);
+				if(result) {
+					return assign(sloc, &lexpr->m.rexpr, result);
+				}
+			}
 			rexpr = evaluate_assignable(env, sloc, rexpr, by);
 			rexpr = assign(sloc, &lexpr->m.rexpr, rexpr);
 			return rexpr;
@@ -2216,6 +2584,7 @@ builtin_referent_assign(
 
 	rexpr = evaluate_instance(env, sloc, rexpr, by);
 	lexpr->m.rexpr = rexpr;
+	gc_remember(lexpr);
 	return rexpr;
 }
 
@@ -2393,11 +2762,83 @@ BUILTIN_ASSIGN(lor)
 BUILTIN_ASSIGN(and)
 BUILTIN_ASSIGN(or)
 BUILTIN_ASSIGN(xor)
-BUILTIN_ASSIGN(add)
-BUILTIN_ASSIGN(sub)
-BUILTIN_ASSIGN(mul)
-BUILTIN_ASSIGN(div)
-BUILTIN_ASSIGN(mod)
+
+// A variable holding a plain number that assign() would simply overwrite is
+// updated in place, rather than a new node being made for every result.
+static inline Ast
+builtin_assign_arithmetic(
+	Ast       env,
+	sloc_t    sloc,
+	Ast       lexpr,
+	Ast       rexpr,
+	Ast     (*builtin)(
+		Ast    env,
+		sloc_t sloc,
+		Ast    lexpr,
+		Ast    rexpr
+	),
+	IntegerOp integerop,
+	FloatOp   floatop
+) {
+	if(ast_isIdentifier(lexpr) && !trace_enabled) {
+		Ast ref = resolve(env, lexpr);
+
+		if(ast_isReference(ref) && ast_isAssignable(ref)) {
+			ref = unwrapref(ref);
+
+			Ast lval = ref->m.rexpr;
+			if((ast_isInteger(lval) || ast_isFloat(lval))
+				&& (lval->attr == ATTR_NoEvaluate) && !lval->cache
+			) {
+				Ast rval = eval(env, rexpr);
+
+				if(ref->m.rexpr == lval) {
+					switch(TYPE(ast_type(lval), ast_type(rval))) {
+					case TYPE(AST_Integer, AST_Boolean):
+					case TYPE(AST_Integer, AST_Integer):
+					case TYPE(AST_Integer, AST_Character):
+						lval->m.ival = integerop(lval->m.ival, rval->m.ival);
+						lval->sloc   = sloc;
+						return lval;
+					case TYPE(AST_Float, AST_Boolean):
+					case TYPE(AST_Float, AST_Integer):
+					case TYPE(AST_Float, AST_Character):
+						lval->m.fval = floatop(lval->m.fval, (double)rval->m.ival);
+						lval->sloc   = sloc;
+						return lval;
+					case TYPE(AST_Float, AST_Float):
+						lval->m.fval = floatop(lval->m.fval, rval->m.fval);
+						lval->sloc   = sloc;
+						return lval;
+					default:
+						break;
+					}
+				}
+
+				rexpr = builtin(env, sloc, lval, rval);
+				return builtin_assign(env, sloc, lexpr, rexpr);
+			}
+		}
+	}
+
+	return builtin_assign_op(env, sloc, lexpr, rexpr, builtin);
+}
+#define BUILTIN_ASSIGN_ARITHMETIC(Name) \
+static Ast \
+builtin_assign_##Name( \
+	Ast    env,   \
+	sloc_t sloc,  \
+	Ast    lexpr, \
+	Ast    rexpr  \
+) { \
+	return builtin_assign_arithmetic(env, sloc, lexpr, rexpr, builtin_##Name, integer_##Name, float_##Name); \
+}
+
+BUILTIN_ASSIGN_ARITHMETIC(add)
+BUILTIN_ASSIGN_ARITHMETIC(sub)
+BUILTIN_ASSIGN_ARITHMETIC(mul)
+BUILTIN_ASSIGN_ARITHMETIC(div)
+BUILTIN_ASSIGN_ARITHMETIC(mod)
 BUILTIN_ASSIGN(shl)
 BUILTIN_ASSIGN(shr)
 BUILTIN_ASSIGN(exl)
@@ -2407,6 +2848,21 @@ BUILTIN_ASSIGN(ror)
 
 //------------------------------------------------------------------------------
 
+static Ast
+exchange_referent(
+	Ast ref
+) {
+	ref = unwrapref(ref);
+
+	Ast ast = ref->m.rexpr;
+	if(ast_isAssignable(ast) && ast_isCopyOnAssign(ast)) {
+		ast = ref->m.rexpr = dup_ast(ast->sloc, ast);
+		gc_remember(ref);
+	}
+
+	return ast;
+}
+
 static Ast
 builtin_exchange_evaluate(
 	Ast    env,
@@ -2427,6 +2883,7 @@ builtin_exchange_evaluate(
 				size_t const index  = iexpr->m.ival;
 				size_t const length = marray_length(ast->m.env);
 				if(index < length) {
+					unshare_env(ast->m.env);
 					ast = marray_at(ast->m.env, Ast, index);
 					ast = deref(ast);
 					if(ast_isAssignable(ast)) {
@@ -2440,8 +2897,11 @@ builtin_exchange_evaluate(
 				size_t const index  = atenv(ast, iexpr);
 				size_t const length = marray_length(ast->m.env);
 				if(index < length) {
+					unshare_env(ast->m.env);
 					ast = marray_at(ast->m.env, Ast, index);
-					ast = deref(ast);
+					if(ast_isReference(ast)) {
+						ast = exchange_referent(ast);
+					}
 					if(ast_isAssignable(ast)) {
 						return ast;
 					}
@@ -2457,7 +2917,7 @@ builtin_exchange_evaluate(
 		ast = subeval(env, ast);
 
 		if(ast_isReference(ast)) {
-			ast = deref(ast);
+			ast = exchange_referent(ast);
 			if(ast_isAssignable(ast)) {
 				return ast;
 			}
@@ -2507,16 +2967,55 @@ builtin_block(
 	Ast    lexpr,
 	Ast    rexpr
 ) {
+	bool const tail = is_tail_operator(lexpr, rexpr);
+
 	if(ast_isnotZen(lexpr)) {
 		env = eval(env, lexpr);
 	}
 
-	return eval(env, rexpr);
+	return tail_eval(env, rexpr, tail);
 	(void)sloc;
 }
 
 //------------------------------------------------------------------------------
 
+static inline bool
+ast_isPlainValue(
+	Ast ast
+) {
+	switch(ast_type(ast)) {
+	case AST_Zen:
+	case AST_Boolean:
+	case AST_Integer:
+	case AST_Float:
+	case AST_Character:
+	case AST_String:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Reading a plain value out of a shared array leaves it shared; anything that
+// may be written through, or that holds mutable state, takes a private copy.
+static Ast
+array_element(
+	Ast    arr,
+	size_t index,
+	bool   value
+) {
+	Ast ent = env_element(arr->m.env, index);
+
+	if(env_isShared(arr->m.env)
+		&& !(value && !(arr->attr & ATTR_NoAssign) && ast_isPlainValue(deref(ent)))
+	) {
+		unshare_env(arr->m.env);
+		ent = marray_at(arr->m.env, Ast, index);
+	}
+
+	return ent;
+}
+
 static Ast
 builtin_array(
 	Ast    env,
@@ -2525,6 +3024,8 @@ builtin_array(
 	Ast    rexpr
 ) {
 	if(ast_isnotZen(lexpr)) {
+		bool const value = is_value_operator(lexpr, rexpr);
+
 		lexpr = eval(env, lexpr);
 		rexpr = eval(env, rexpr);
 
@@ -2534,28 +3035,42 @@ builtin_array(
 		case TYPE(AST_Environment, AST_Character): {
 				size_t const index = rexpr->m.ival;
 				if(index < marray_length(lexpr->m.env)) {
-					rexpr = marray_at(lexpr->m.env, Ast, index);
+					rexpr = array_element(lexpr, index, value);
 					rexpr->attr |= lexpr->attr & ATTR_NoAssign;
 					return rexpr;
 				}
 			}
 			return oboerr(sloc, ERR_InvalidOperand);
-		case TYPE(AST_Environment, AST_String):
-			rexpr = inenv(lexpr, rexpr);
-			rexpr->attr |= lexpr->attr & ATTR_NoAssign;
+		case TYPE(AST_Environment, AST_String): {
+				size_t const index = atenv(lexpr, rexpr);
+				rexpr = (index < marray_length(lexpr->m.env)) ? (
+					array_element(lexpr, index, value)
+				) : (
+					inenv(lexpr, rexpr)
+				);
+				rexpr->attr |= lexpr->attr & ATTR_NoAssign;
+			}
 			return rexpr;
 		case TYPE(AST_String, AST_Boolean):
 		case TYPE(AST_String, AST_Integer):
 		case TYPE(AST_String, AST_Character): {
 				char const *cs = StringToCharLiteral(lexpr->m.sval, NULL);
-				utf8off(cs, &cs, rexpr->m.ival);
+				cs += StringCodePointOffset(lexpr->m.sval, rexpr->m.ival);
 				char32_t const c = utf8chr(cs, NULL);
 				if(~c) {
-					return new_ast(rexpr->sloc, AST_Character, c);
+					return new_immediate(rexpr->sloc, AST_Character, c);
 				}
 			}
 			return oboerr(sloc, ERR_InvalidOperand);
 		default:
+			if(ast_isVector(lexpr)) switch(ast_type(rexpr)) {
+			case AST_Boolean:
+			case AST_Integer:
+			case AST_Character:
+				return vector_element(sloc, lexpr, rexpr->m.ival);
+			default:
+				break;
+			}
 			if(ast_isRange(rexpr)) switch(ast_type(lexpr)) {
 			case AST_Environment: {
 				size_t length = marray_length(lexpr->m.env);
@@ -2570,29 +3085,25 @@ builtin_array(
 				if((start < length) && (end < length)) {
 					length = end - start + 1;
 
-					Array  arr = arrintop_alloc();
-					arrintop_resize(arr, length);
-					arrintop_copy  (arr, 0, lexpr->m.env, start, length);
+					Array arr = window_env(lexpr->m.env, start, length);
 
 					return new_ast(sloc, AST_Environment, arr, NULL);
 				}
 				break;
 			}
 			case AST_String: {
-				size_t      length;
-				char const *cs    = StringToCharLiteral(lexpr->m.sval, &length);
-				length            = utf8len(cs, NULL, length);
-				size_t      start = ast_toInteger(eval(env, rexpr->m.lexpr));
-				Ast         ast   = eval(env, rexpr->m.rexpr);
-				size_t      end   = ast_isZen(ast) ? length - !!length : ast_toInteger(ast);
+				size_t length = StringCodePoints(lexpr->m.sval);
+				size_t start  = ast_toInteger(eval(env, rexpr->m.lexpr));
+				Ast    ast    = eval(env, rexpr->m.rexpr);
+				size_t end    = ast_isZen(ast) ? length - !!length : ast_toInteger(ast);
 				if(start > end) {
 					size_t temp = start;
 					start       = end;
 					end         = temp;
 				}
 				if((start < length) && (end < length)) {
-					start = utf8off(cs, NULL, start);
-					end   = utf8off(cs, NULL, end + 1);
+					start = StringCodePointOffset(lexpr->m.sval, start);
+					end   = StringCodePointOffset(lexpr->m.sval, end + 1);
 
 					String s = (length > 0) ? (
 						SubString(lexpr->m.sval, start, end - start)
@@ -2663,6 +3174,9 @@ builtin_applicate(
 	Ast    lexpr,
 	Ast    rexpr
 ) {
+	bool const tail  = is_tail_operator(lexpr, rexpr);
+	bool const value = is_value_operator(lexpr, rexpr);
+
 	if(ast_isApplicate(lexpr)) {
 		Ast ast = eval(env, lexpr->m.lexpr);
 
@@ -2702,6 +3216,7 @@ builtin_applicate(
 				Array statics_env = statics->m.env;
 				Ast   locals_save = source_env(sloc_source(rexpr->sloc));
 				statics->m.env    = locals_save->m.env;
+				gc_remember(statics);
 
 				locals_save = locals;
 				locals = new_env(sloc, env);
@@ -2710,6 +3225,7 @@ builtin_applicate(
 				locals = locals_save;
 
 				statics->m.env = statics_env;
+				gc_remember(statics);
 				return rexpr;
 			}
 		case AST_BuiltinFunction:
@@ -2736,6 +3252,7 @@ builtin_applicate(
 				Array statics_env = statics->m.env;
 				Ast   locals_save = source_env(sloc_source(rexpr->sloc));
 				statics->m.env    = locals_save->m.env;
+				gc_remember(statics);
 
 				locals_save = locals;
 				locals = new_env(sloc, env);
@@ -2744,6 +3261,7 @@ builtin_applicate(
 				locals = locals_save;
 
 				statics->m.env = statics_env;
+				gc_remember(statics);
 				return rexpr;
 			}
 		case AST_BuiltinFunction:
@@ -2823,22 +3341,17 @@ builtin_applicate(
 	case AST_BuiltinFunction:
 		return lexpr->m.bfn(env, sloc, rexpr);
 	case AST_Function: {
-			Array statics_env = statics->m.env;
-			Ast   locals_save = source_env(sloc_source(lexpr->sloc));
-			statics->m.env    = locals_save->m.env;
-
-			locals_save = locals;
-			locals = new_env(sloc, env);
-			addenv_args(locals, env, sloc, lexpr->m.lexpr, rexpr);
-			rexpr = eval(locals, lexpr->m.rexpr);
-			locals = locals_save;
-
-			statics->m.env = statics_env;
-			return rexpr;
+			Ast source = source_env(sloc_source(lexpr->sloc));
+			return invoke(env, sloc, lexpr, source->m.env, rexpr, tail);
 		}
 	case AST_Environment:
 		if(ast_isIdentifier(rexpr) || ast_isString(rexpr)) {
-			rexpr = inenv(lexpr, rexpr);
+			size_t const index = atenv(lexpr, rexpr);
+			rexpr = (index < marray_length(lexpr->m.env)) ? (
+				array_element(lexpr, index, value)
+			) : (
+				inenv(lexpr, rexpr)
+			);
 			if(ast_isnotZen(rexpr)) {
 				rexpr->attr |= lexpr->attr & ATTR_NoAssign;
 				return rexpr;
@@ -2854,18 +3367,8 @@ builtin_applicate(
 			return lexpr;
 		case AST_Error:
 			return rexpr;
-		default: {
-				Ast texpr;
-				for(texpr = lexpr;
-					ast_isSequence(texpr->m.rexpr);
-					texpr = lexpr->m.rexpr
-				);
-				if(ast_isnotZen(texpr->m.rexpr)) {
-					rexpr = new_ast(sloc, AST_Sequence, texpr->m.rexpr, rexpr);
-				}
-				texpr->m.rexpr = rexpr;
-				return lexpr;
-			}
+		default:
+			return sequence_append(sloc, lexpr, rexpr);
 		}
 		break;
 	}
@@ -3139,6 +3642,45 @@ initialise_builtin_operators(
 	};
 	static size_t const n_builtinalias = sizeof(builtinalias) / sizeof(builtinalias[0]);
 
+#	define LOWERING(Name, Lowering, IntegerOp, FloatOp, FloatCmp) \
+		{ builtin_##Name, LOWER_##Lowering, IntegerOp, FloatOp, FloatCmp },
+	static struct builtinlowering const builtinlowering[] = {
+		LOWERING(land, LogicalAnd, NULL        , NULL       , NULL      )
+		LOWERING(lor , LogicalOr , NULL        , NULL       , NULL      )
+		LOWERING(lt  , Compare   , integer_lt  , NULL       , float_lt  )
+		LOWERING(lte , Compare   , integer_lte , NULL       , float_lte )
+		LOWERING(eq  , Compare   , integer_eq  , NULL       , float_eq  )
+		LOWERING(neq , Compare   , integer_neq , NULL       , float_neq )
+		LOWERING(gte , Compare   , integer_gte , NULL       , float_gte )
+		LOWERING(gt  , Compare   , integer_gt  , NULL       , float_gt  )
+		LOWERING(and , Bitwise   , integer_and , NULL       , NULL      )
+		LOWERING(or  , Bitwise   , integer_or  , NULL       , NULL      )
+		LOWERING(xor , Bitwise   , integer_xor , NULL       , NULL      )
+		LOWERING(add , Arithmetic, integer_add , float_add  , NULL      )
+		LOWERING(sub , Arithmetic, integer_sub , float_sub  , NULL      )
+		LOWERING(mul , Arithmetic, integer_mul , float_mul  , NULL      )
+		LOWERING(div , Arithmetic, integer_div , float_div  , NULL      )
+		LOWERING(mod , Arithmetic, integer_mod , float_mod  , NULL      )
+		LOWERING(shl , Bitmove   , integer_shl , NULL       , NULL      )
+		LOWERING(shr , Bitmove   , integer_shr , NULL       , NULL      )
+		LOWERING(exl , Bitmove   , integer_exl , NULL       , NULL      )
+		LOWERING(exr , Bitmove   , integer_exr , NULL       , NULL      )
+		LOWERING(rol , Bitmove   , integer_rol , NULL       , NULL      )
+		LOWERING(ror , Bitmove   , integer_ror , NULL       , NULL      )
+	};
+	static size_t const n_builtinlowering = sizeof(builtinlowering) / sizeof(builtinlowering[0]);
+#	undef LOWERING
+
+	static BuiltinOp const builtinfolding[] = {
+		builtin_applicate,
+		builtin_land, builtin_lor,
+		builtin_lt, builtin_lte, builtin_eq, builtin_neq, builtin_gte, builtin_gt,
+		builtin_and, builtin_or, builtin_xor,
+		builtin_add, builtin_sub, builtin_mul, builtin_div, builtin_mod,
+		builtin_shl, builtin_shr, builtin_exl, builtin_exr, builtin_rol, builtin_ror,
+	};
+	static size_t const n_builtinfolding = sizeof(builtinfolding) / sizeof(builtinfolding[0]);
+
 	static bool initialise = true;
 
 	if(initialise) {
@@ -3148,6 +3690,8 @@ initialise_builtin_operators(
 		if(!no_alias) {
 			initialise_builtinalias(operators, builtinalias, n_builtinalias);
 		}
+		initialise_builtinlowering(builtinlowering, n_builtinlowering);
+		initialise_builtinfolding(builtinfolding, n_builtinfolding);
 	}
 
 	return EXIT_SUCCESS;
@@ -26,6 +26,7 @@ SOFTWARE.
 
 #include "ast.h"
 #include "parse.h"
+#include <math.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,6 +34,58 @@ extern "C" {
 
 //------------------------------------------------------------------------------
 
+typedef uint64_t (*IntegerOp)(uint64_t, uint64_t);
+typedef double   (*FloatOp)(double, double);
+typedef uint64_t (*IntegerCmp)(uint64_t, uint64_t);
+typedef uint64_t (*FloatCmp)(double, double);
+
+#define INTEGEROP(Name,...) \
+	uint64_t \
+	integer_##Name( \
+		uint64_t lval, \
+		uint64_t rval  \
+	) { \
+		__VA_ARGS__; \
+	}
+
+#define FLOATOP(Name,...) \
+	double \
+	float_##Name( \
+		double lval, \
+		double rval  \
+	) { \
+		__VA_ARGS__; \
+	}
+
+// The scalar operations, shared by the operator builtins and vector kernels.
+// A shift count is taken modulo 64; extracting or rotating by 0 bits yields
+// lval unchanged.
+
+static inline INTEGEROP(add, return lval + rval)
+static inline INTEGEROP(sub, return lval - rval)
+static inline INTEGEROP(mul, return lval * rval)
+static inline INTEGEROP(div, return (rval != 0) ? lval / rval : 0)
+static inline INTEGEROP(mod, return (rval != 0) ? lval % rval : 0)
+
+static inline INTEGEROP(and, return lval & rval)
+static inline INTEGEROP(or , return lval | rval)
+static inline INTEGEROP(xor, return lval ^ rval)
+
+static inline INTEGEROP(shl, rval &= 63; return lval << rval)
+static inline INTEGEROP(shr, rval &= 63; return lval >> rval)
+static inline INTEGEROP(exl, rval &= 63; return rval ? lval >> (64 - rval) : lval)
+static inline INTEGEROP(exr, rval &= 63; return rval ? lval & (UINT64_C(~0) >> (64 - rval)) : lval)
+static inline INTEGEROP(rol, rval &= 63; return rval ? (lval << rval) | (lval >> (64 - rval)) : lval)
+static inline INTEGEROP(ror, rval &= 63; return rval ? (lval << (64 - rval)) | (lval >> rval) : lval)
+
+static inline FLOATOP(add, return !isunordered(lval, rval) ? lval + rval : 0.0)
+static inline FLOATOP(sub, return !isunordered(lval, rval) ? lval - rval : 0.0)
+static inline FLOATOP(mul, return !isunordered(lval, rval) ? lval * rval : 0.0)
+static inline FLOATOP(div, return !isunordered(lval, rval) ? (islessgreater(rval, 0.0) ? lval / rval : 0.0) : 0.0)
+static inline FLOATOP(mod, return !isunordered(lval, rval) ? (islessgreater(rval, 0.0) ? fmod(lval, rval) : 0.0) : 0.0)
+
+//------------------------------------------------------------------------------
+
 struct builtinop {
 	char const *leme;
 	BuiltinOp   func;
@@ -86,6 +139,16 @@ initialise_builtins(
 
 //------------------------------------------------------------------------------
 
+extern int
+compare_less(
+	Ast    env,
+	sloc_t sloc,
+	Ast    lexpr,
+	Ast    rexpr
+);
+
+//------------------------------------------------------------------------------
+
 extern String
 mapoboefile(
 	StringConst file
@@ -0,0 +1,139 @@
+/*
+MIT License
+
+Copyright (c) 2019 Tristan Styles
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "cache.h"
+#include "assert.h"
+#include <stdlib.h>
+
+//------------------------------------------------------------------------------
+
+struct cache {
+	Ast       ast;
+	CacheKind kind;
+	void     *data;
+	void    (*release)(void *);
+	void    (*mark)(void *, void (*)(void const *));
+	unsigned  next;
+};
+
+static struct cache *cache_table = NULL;
+static unsigned      cache_size  = 0;
+static unsigned      cache_free  = 0;
+
+//------------------------------------------------------------------------------
+
+void *
+ast_cache(
+	Ast       ast,
+	CacheKind kind
+) {
+	unsigned index = ast->cache;
+
+	if(index && (index < cache_size)
+		&& (cache_table[index].ast == ast)
+		&& (cache_table[index].kind == kind)
+	) {
+		return cache_table[index].data;
+	}
+
+	return NULL;
+}
+
+void *
+set_ast_cache(
+	Ast       ast,
+	CacheKind kind,
+	void     *data,
+	void    (*release)(void *),
+	void    (*mark)(void *, void (*)(void const *))
+) {
+	drop_ast_cache(ast);
+
+	unsigned index = cache_free;
+	if(index) {
+		cache_free = cache_table[index].next;
+
+	} else {
+		if(cache_size == 0) {
+			cache_size = 1;
+		}
+		size_t size = (size_t)cache_size * 2;
+		if(size > UINT_MAX) {
+			return NULL;
+		}
+		struct cache *table = realloc(cache_table, size * sizeof(*table));
+		if(!table) {
+			return NULL;
+		}
+		cache_table = table;
+		for(size_t i = size; i-- > cache_size; ) {
+			cache_table[i] = (struct cache){ NULL, CACHE_None, NULL, NULL, NULL, cache_free };
+			cache_free     = (unsigned)i;
+		}
+		cache_size = (unsigned)size;
+
+		index      = cache_free;
+		cache_free = cache_table[index].next;
+	}
+
+	cache_table[index] = (struct cache){ ast, kind, data, release, mark, 0 };
+	ast->cache         = index;
+
+	return data;
+}
+
+void
+mark_ast_cache(
+	Ast    ast,
+	void (*gc_mark)(void const *)
+) {
+	unsigned index = ast->cache;
+
+	if(index && (index < cache_size) && (cache_table[index].ast == ast)) {
+		struct cache *entry = &cache_table[index];
+		if(entry->mark) {
+			entry->mark(entry->data, gc_mark);
+		}
+	}
+
+	return;
+}
+
+void
+drop_ast_cache(
+	Ast ast
+) {
+	unsigned index = ast->cache;
+
+	if(index && (index < cache_size) && (cache_table[index].ast == ast)) {
+		struct cache *entry = &cache_table[index];
+		if(entry->release) {
+			entry->release(entry->data);
+		}
+		*entry     = (struct cache){ NULL, CACHE_None, NULL, NULL, NULL, cache_free };
+		cache_free = index;
+	}
+
+	ast->cache = 0;
+	return;
+}
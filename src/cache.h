@@ -0,0 +1,76 @@
+#ifndef CACHE_H_INCLUDED
+#define CACHE_H_INCLUDED
+/*
+MIT License
+
+Copyright (c) 2019 Tristan Styles
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ast.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//------------------------------------------------------------------------------
+
+typedef enum {
+	CACHE_None,
+	CACHE_Code,
+	CACHE_Slot,
+	CACHE_Operator,
+	CACHE_Case,
+	CACHE_Sequence
+} CacheKind;
+
+extern void *
+ast_cache(
+	Ast       ast,
+	CacheKind kind
+);
+
+extern void *
+set_ast_cache(
+	Ast       ast,
+	CacheKind kind,
+	void     *data,
+	void    (*release)(void *),
+	void    (*mark)(void *, void (*)(void const *))
+);
+
+extern void
+mark_ast_cache(
+	Ast    ast,
+	void (*gc_mark)(void const *)
+);
+
+extern void
+drop_ast_cache(
+	Ast ast
+);
+
+//------------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif//ndef CACHE_H_INCLUDED
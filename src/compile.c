@@ -0,0 +1,794 @@
+/*
+MIT License
+
+Copyright (c) 2019 Tristan Styles
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "compile.h"
+#include "cache.h"
+#include "eval.h"
+#include "env.h"
+#include "trace.h"
+#include "assert.h"
+#include "gc.h"
+#include <stdlib.h>
+#include <math.h>
+
+//------------------------------------------------------------------------------
+
+#define MAX_REGISTERS  32
+#define MAX_DEOPTIMISE  4
+
+typedef enum {
+	OP_Const,
+	OP_Load,
+	OP_Eval,
+	OP_Binary,
+	OP_IntegerBinary,
+	OP_IntegerCompare,
+	OP_FloatBinary,
+	OP_FloatCompare,
+	OP_Test,
+	OP_BranchIfFalse,
+	OP_BranchIfTrue
+} Opcode;
+
+struct instr {
+	Opcode   opcode;
+	unsigned dst;
+	unsigned lhs;
+	unsigned rhs;
+	unsigned deopt;
+	sloc_t   sloc;
+	union {
+		Ast                           ast;
+		struct builtinlowering const *op;
+		size_t                        target;
+	};
+};
+
+typedef struct code *Code;
+struct code {
+	size_t       ninstr;
+	struct instr instr[];
+};
+
+struct reg {
+	Ast      ast;
+	Type     type;
+	sloc_t   sloc;
+	union {
+		uint64_t ival;
+		double   fval;
+	};
+};
+
+//------------------------------------------------------------------------------
+
+static struct builtinlowering const *lowering_table = NULL;
+static size_t                        lowering_count = 0;
+
+int
+initialise_builtinlowering(
+	struct builtinlowering const builtinlowering[],
+	size_t                       n_builtinlowering
+) {
+	lowering_table = builtinlowering;
+	lowering_count = n_builtinlowering;
+
+	return EXIT_SUCCESS;
+}
+
+static struct builtinlowering const *
+lowering_of(
+	Ast ast
+) {
+	if(ast_isOperator(ast)) {
+		Ast oper = getopr(ast->qual);
+		if(ast_isBuiltinOperator(oper)) {
+			for(size_t i = 0; i < lowering_count; i++) {
+				if(lowering_table[i].func == oper->m.bop) {
+					return &lowering_table[i];
+				}
+			}
+		}
+	}
+
+	return NULL;
+}
+
+//------------------------------------------------------------------------------
+
+struct compiler {
+	struct instr *instr;
+	size_t        ninstr;
+	size_t        capacity;
+	bool          failed;
+};
+
+static size_t
+emit(
+	struct compiler *c,
+	struct instr     instr
+) {
+	if(c->ninstr == c->capacity) {
+		size_t        capacity = c->capacity ? c->capacity * 2 : 16;
+		struct instr *p        = realloc(c->instr, capacity * sizeof(*p));
+		if(!p) {
+			c->failed = true;
+			return c->ninstr;
+		}
+		c->instr    = p;
+		c->capacity = capacity;
+	}
+
+	c->instr[c->ninstr] = instr;
+	return c->ninstr++;
+}
+
+static void
+lower(
+	struct compiler *c,
+	Ast              ast,
+	unsigned         dst
+) {
+	if(!ast) {
+		ast = ZEN;
+	}
+
+	if(ast->attr & ATTR_NoEvaluate) {
+		emit(c, (struct instr){ OP_Const, dst, 0, 0, 0, ast->sloc, { .ast = ast } });
+		return;
+	}
+
+	if(ast_isIdentifier(ast)) {
+		emit(c, (struct instr){ OP_Load, dst, 0, 0, 0, ast->sloc, { .ast = ast } });
+		return;
+	}
+
+	struct builtinlowering const *op = lowering_of(ast);
+	if(!op || ((dst + 1) >= MAX_REGISTERS)) {
+		emit(c, (struct instr){ OP_Eval, dst, 0, 0, 0, ast->sloc, { .ast = ast } });
+		return;
+	}
+
+	switch(op->lowering) {
+	case LOWER_LogicalAnd:
+	case LOWER_LogicalOr: {
+			Opcode branch = (op->lowering == LOWER_LogicalAnd) ? OP_BranchIfFalse : OP_BranchIfTrue;
+			lower(c, ast->m.lexpr, dst);
+			emit(c, (struct instr){ OP_Test, dst, dst, 0, 0, ast->sloc, { .op = op } });
+			size_t x = emit(c, (struct instr){ branch, dst, dst, 0, 0, ast->sloc, { .target = 0 } });
+			lower(c, ast->m.rexpr, dst);
+			emit(c, (struct instr){ OP_Test, dst, dst, 0, 0, ast->sloc, { .op = op } });
+			if(!c->failed) {
+				c->instr[x].target = c->ninstr;
+			}
+		}
+		break;
+	default:
+		lower(c, ast->m.lexpr, dst);
+		lower(c, ast->m.rexpr, dst + 1);
+		emit(c, (struct instr){ OP_Binary, dst, dst, dst + 1, 0, ast->sloc, { .op = op } });
+		break;
+	}
+
+	return;
+}
+
+bool
+reads_only(
+	Ast ast
+) {
+	if(!ast || (ast->attr & ATTR_NoEvaluate) || ast_isIdentifier(ast)) {
+		return true;
+	}
+
+	struct builtinlowering const *op = lowering_of(ast);
+	return op && reads_only(ast->m.lexpr) && reads_only(ast->m.rexpr);
+}
+
+//------------------------------------------------------------------------------
+
+static BuiltinOp const *folding_table = NULL;
+static size_t           folding_count = 0;
+
+int
+initialise_builtinfolding(
+	BuiltinOp const builtinfolding[],
+	size_t          n_builtinfolding
+) {
+	folding_table = builtinfolding;
+	folding_count = n_builtinfolding;
+
+	return EXIT_SUCCESS;
+}
+
+static BuiltinOp
+folding_of(
+	Ast oper
+) {
+	if(ast_isBuiltinOperator(oper)) {
+		for(size_t i = 0; i < folding_count; i++) {
+			if(folding_table[i] == oper->m.bop) {
+				return oper->m.bop;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+static bool
+is_literal(
+	Ast ast
+) {
+	if(ast && (ast->attr & ATTR_NoEvaluate)) {
+		switch(ast_type(ast)) {
+		case AST_Zen:
+		case AST_Boolean:
+		case AST_Integer:
+		case AST_Float:
+		case AST_Character:
+		case AST_String:
+			return true;
+		default:
+			break;
+		}
+	}
+
+	return false;
+}
+
+static Ast
+fold_operator(
+	Ast env,
+	Ast ast
+);
+
+static Ast
+fold_ast(
+	Ast env,
+	Ast ast
+) {
+	Ast  root = ast;
+	Ast *link = &root;
+
+	for(; (*link)
+		&& !((*link)->attr & ATTR_NoEvaluate)
+		&& (ast_isSequence(*link) || ast_isAssemblage(*link));
+		link = &(*link)->m.rexpr
+	) {
+		Ast lexpr = fold_ast(env, (*link)->m.lexpr);
+		if(lexpr != (*link)->m.lexpr) {
+			(*link)->m.lexpr = gc_link(lexpr);
+			gc_remember(*link);
+		}
+	}
+
+	if(ast_isOperator(*link)) {
+		Ast rexpr = fold_operator(env, *link);
+		if(rexpr != *link) {
+			*link = gc_remember(gc_link(rexpr));
+		}
+	}
+
+	return root;
+}
+
+// Binding targets are left as written: declaration heads are made of
+// juxtaposed literals, and a declaration with no target quotes its value.
+static Ast
+fold_operator(
+	Ast env,
+	Ast ast
+) {
+	Ast const oper = getopr(ast->qual);
+
+	bool const binding = ast_isBuiltinOperator(oper) && (oper->qual <= P_Assigning);
+	if(!binding) {
+		Ast lexpr = fold_ast(env, ast->m.lexpr);
+		if(lexpr != ast->m.lexpr) {
+			ast->m.lexpr = gc_link(lexpr);
+			gc_remember(ast);
+		}
+	}
+	if(!binding || ast_isnotZen(ast->m.lexpr)) {
+		Ast rexpr = fold_ast(env, ast->m.rexpr);
+		if(rexpr != ast->m.rexpr) {
+			ast->m.rexpr = gc_link(rexpr);
+			gc_remember(ast);
+		}
+	}
+
+	BuiltinOp const bop = folding_of(oper);
+	if(bop && is_literal(ast->m.lexpr) && is_literal(ast->m.rexpr)) {
+		tail_operator = NULL;
+
+		Ast result = bop(env, ast->sloc, ast->m.lexpr, ast->m.rexpr);
+		if(is_literal(result) && ast_isnotZen(result)) {
+			result->attr |= ATTR_CopyOnAssign;
+			return result;
+		}
+	}
+
+	return ast;
+}
+
+Ast
+fold(
+	Ast env,
+	Ast ast
+) {
+	if(!ast || trace_enabled) {
+		return ast;
+	}
+
+	return gc_push(fold_ast(env, ast));
+}
+
+//------------------------------------------------------------------------------
+
+static void
+release_code(
+	void *p
+) {
+	free(p);
+}
+
+static Code
+compile_operator(
+	Ast ast
+) {
+	struct compiler c    = { NULL, 0, 0, false };
+	Code            code = NULL;
+
+	lower(&c, ast, 0);
+
+	if(!c.failed) {
+		code = malloc(sizeof(*code) + (c.ninstr * sizeof(struct instr)));
+		if(code) {
+			code->ninstr = c.ninstr;
+			memcpy(code->instr, c.instr, c.ninstr * sizeof(struct instr));
+			if(!set_ast_cache(ast, CACHE_Code, code, release_code, NULL)) {
+				free(code);
+				code = NULL;
+			}
+		}
+	}
+
+	free(c.instr);
+	return code;
+}
+
+void
+compile(
+	Ast ast
+) {
+	for(; ast && !(ast->attr & ATTR_NoEvaluate); ast = ast->m.rexpr) {
+		switch(ast_type(ast)) {
+		case AST_Operator:
+			if(lowering_of(ast)) {
+				Code code = ast_cache(ast, CACHE_Code);
+				if(!code) {
+					code = compile_operator(ast);
+				}
+				if(code) {
+					for(size_t i = 0; i < code->ninstr; i++) {
+						if(code->instr[i].opcode == OP_Eval) {
+							compile(code->instr[i].ast);
+						}
+					}
+					return;
+				}
+			}
+			compile(ast->m.lexpr);
+			continue;
+		case AST_Sequence:
+		case AST_Assemblage:
+			compile(ast->m.lexpr);
+			continue;
+		case AST_Quoted:
+			continue;
+		default:
+			return;
+		}
+	}
+
+	return;
+}
+
+//------------------------------------------------------------------------------
+
+typedef enum {
+	KIND_Integer,
+	KIND_Float,
+	KIND_Zen,
+	KIND_Other
+} Kind;
+
+static inline Kind
+kind_of(
+	Type type
+) {
+	switch(type) {
+	case AST_Boolean:
+	case AST_Integer:
+	case AST_Character:
+		return KIND_Integer;
+	case AST_Float:
+		return KIND_Float;
+	case AST_Zen:
+		return KIND_Zen;
+	default:
+		return KIND_Other;
+	}
+}
+
+static inline void
+load_reg(
+	struct reg *r,
+	Ast         ast
+) {
+	r->ast  = ast;
+	r->type = ast_type(ast);
+	if(ast) {
+		r->ival = ast->m.ival;
+	}
+}
+
+static inline Ast
+box_reg(
+	struct reg *r
+) {
+	if(!r->ast) {
+		switch(r->type) {
+		case AST_Float:
+			r->ast = new_ast(r->sloc, AST_Float, r->fval);
+			break;
+		default:
+			r->ast = new_immediate(r->sloc, r->type, r->ival);
+			break;
+		}
+	}
+
+	return r->ast;
+}
+
+static inline uint64_t
+double_to_uint64_t(
+	double v
+) {
+	return ((union { double d; uint64_t u; }){ .d = v }).u;
+}
+
+static inline uint64_t
+integer_of(
+	struct reg const *r,
+	Kind              k,
+	bool              bits
+) {
+	switch(k) {
+	case KIND_Integer: return r->ival;
+	case KIND_Float:   return bits ? double_to_uint64_t(r->fval) : (uint64_t)r->fval;
+	default:           return 0;
+	}
+}
+
+static inline double
+float_of(
+	struct reg const *r,
+	Kind              k
+) {
+	switch(k) {
+	case KIND_Integer: return (double)r->ival;
+	case KIND_Float:   return r->fval;
+	default:           return 0.0;
+	}
+}
+
+static inline bool
+bool_of(
+	struct reg const *r
+) {
+	if(r->ast) {
+		return ast_toBool(r->ast);
+	}
+
+	switch(r->type) {
+	case AST_Float:
+		return !isunordered(r->fval, 0.0) && !islessgreater(r->fval, 0.0);
+	default:
+		return r->ival != 0;
+	}
+}
+
+static Ast
+load_identifier(
+	Ast env,
+	Ast ast
+) {
+	Ast ref = resolve(env, ast);
+
+	if(ast_isReference(ref)) {
+		Ast val = ref;
+		do {
+			val = val->m.rexpr;
+		} while(ast_isReference(val));
+
+		if(val && (val->attr & ATTR_NoEvaluate) && ast_isnotQuoted(val)) {
+			return val;
+		}
+	}
+
+	return eval(env, ast);
+}
+
+static void
+binary(
+	Ast                 env,
+	struct instr const *in,
+	struct reg         *d,
+	struct reg         *l,
+	struct reg         *r
+) {
+	if(l->ast) load_reg(l, l->ast);
+	if(r->ast) load_reg(r, r->ast);
+
+	Kind const lk = kind_of(l->type);
+	Kind const rk = kind_of(r->type);
+
+	if((lk == KIND_Other) || (rk == KIND_Other) || ((lk == KIND_Zen) && (rk == KIND_Zen))) {
+		Ast lexpr = box_reg(l);
+		Ast rexpr = box_reg(r);
+		load_reg(d, in->op->func(env, in->sloc, lexpr, rexpr));
+		return;
+	}
+
+	bool const is_float = (lk == KIND_Float) || (rk == KIND_Float);
+
+	d->ast  = NULL;
+	d->sloc = in->sloc;
+
+	switch(in->op->lowering) {
+	case LOWER_Arithmetic:
+		if(is_float) {
+			d->type = AST_Float;
+			d->fval = in->op->floatop(float_of(l, lk), float_of(r, rk));
+		} else {
+			d->type = AST_Integer;
+			d->ival = in->op->integerop(integer_of(l, lk, false), integer_of(r, rk, false));
+		}
+		break;
+	case LOWER_Bitwise:
+		d->type = AST_Integer;
+		d->ival = in->op->integerop(integer_of(l, lk, true), integer_of(r, rk, true));
+		break;
+	case LOWER_Bitmove:
+		d->type = AST_Integer;
+		d->ival = in->op->integerop(integer_of(l, lk, true), integer_of(r, rk, false));
+		break;
+	case LOWER_Compare:
+		d->type = AST_Boolean;
+		d->ival = is_float ? (
+			in->op->floatcmp(float_of(l, lk), float_of(r, rk))
+		) : (
+			in->op->integerop(integer_of(l, lk, false), integer_of(r, rk, false))
+		);
+		d->ival = (d->ival != 0);
+		break;
+	default:
+		break;
+	}
+
+	return;
+}
+
+//------------------------------------------------------------------------------
+
+static inline bool
+guard_integer(
+	struct reg *r
+) {
+	if(r->ast) load_reg(r, r->ast);
+	return kind_of(r->type) == KIND_Integer;
+}
+
+static inline bool
+guard_float(
+	struct reg *r
+) {
+	if(r->ast) load_reg(r, r->ast);
+	return r->type == AST_Float;
+}
+
+static void
+quicken(
+	struct instr     *in,
+	struct reg const *l,
+	struct reg const *r
+) {
+	if(in->deopt >= MAX_DEOPTIMISE) {
+		return;
+	}
+
+	Kind const lk = kind_of(l->type);
+	Kind const rk = kind_of(r->type);
+
+	if((lk == KIND_Integer) && (rk == KIND_Integer)) {
+		in->opcode = (in->op->lowering == LOWER_Compare) ? OP_IntegerCompare : OP_IntegerBinary;
+
+	} else if((lk == KIND_Float) && (rk == KIND_Float)) {
+		switch(in->op->lowering) {
+		case LOWER_Arithmetic:
+			in->opcode = OP_FloatBinary;
+			break;
+		case LOWER_Compare:
+			in->opcode = OP_FloatCompare;
+			break;
+		default:
+			break;
+		}
+	}
+
+	return;
+}
+
+static void
+deoptimise(
+	struct instr *in
+) {
+	in->opcode = OP_Binary;
+	in->deopt++;
+}
+
+// A number held in a register can be stored straight into a node of the same
+// type that assign() would simply overwrite, instead of being boxed first.
+static inline bool
+store_reg(
+	struct reg *r,
+	sloc_t      sloc,
+	Ast         target
+) {
+	if(r->ast
+		|| !target
+		|| (ast_type(target) != r->type)
+		|| (target->attr != ATTR_NoEvaluate)
+		|| target->cache
+	) {
+		return false;
+	}
+
+	target->sloc   = sloc;
+	target->m.ival = r->ival;
+	return true;
+}
+
+Ast
+execute(
+	Ast env,
+	Ast ast
+) {
+	return execute_into(env, ast, 0, NULL);
+}
+
+Ast
+execute_into(
+	Ast    env,
+	Ast    ast,
+	sloc_t sloc,
+	Ast    target
+) {
+	Code code = ast_cache(ast, CACHE_Code);
+	if(!code) {
+		return NULL;
+	}
+
+	struct reg reg[MAX_REGISTERS];
+
+	for(size_t pc = 0; pc < code->ninstr; pc++) {
+		struct instr *in = &code->instr[pc];
+		struct reg   *d  = &reg[in->dst];
+		struct reg   *l  = &reg[in->lhs];
+		struct reg   *r  = &reg[in->rhs];
+
+		switch(in->opcode) {
+		case OP_Const:
+			load_reg(d, in->ast);
+			break;
+		case OP_Load:
+			load_reg(d, load_identifier(env, in->ast));
+			break;
+		case OP_Eval:
+			load_reg(d, eval(env, in->ast));
+			break;
+		case OP_Binary:
+			binary(env, in, d, l, r);
+			quicken(in, l, r);
+			break;
+		case OP_IntegerBinary:
+			if(guard_integer(l) && guard_integer(r)) {
+				d->ast  = NULL;
+				d->type = AST_Integer;
+				d->sloc = in->sloc;
+				d->ival = in->op->integerop(l->ival, r->ival);
+				break;
+			}
+			deoptimise(in);
+			binary(env, in, d, l, r);
+			break;
+		case OP_IntegerCompare:
+			if(guard_integer(l) && guard_integer(r)) {
+				d->ast  = NULL;
+				d->type = AST_Boolean;
+				d->sloc = in->sloc;
+				d->ival = (in->op->integerop(l->ival, r->ival) != 0);
+				break;
+			}
+			deoptimise(in);
+			binary(env, in, d, l, r);
+			break;
+		case OP_FloatBinary:
+			if(guard_float(l) && guard_float(r)) {
+				d->ast  = NULL;
+				d->type = AST_Float;
+				d->sloc = in->sloc;
+				d->fval = in->op->floatop(l->fval, r->fval);
+				break;
+			}
+			deoptimise(in);
+			binary(env, in, d, l, r);
+			break;
+		case OP_FloatCompare:
+			if(guard_float(l) && guard_float(r)) {
+				d->ast  = NULL;
+				d->type = AST_Boolean;
+				d->sloc = in->sloc;
+				d->ival = (in->op->floatcmp(l->fval, r->fval) != 0);
+				break;
+			}
+			deoptimise(in);
+			binary(env, in, d, l, r);
+			break;
+		case OP_Test:
+			d->ival = bool_of(l);
+			d->ast  = NULL;
+			d->type = AST_Boolean;
+			d->sloc = in->sloc;
+			break;
+		case OP_BranchIfFalse:
+			if(!d->ival) {
+				pc = in->target - 1;
+			}
+			break;
+		case OP_BranchIfTrue:
+			if(d->ival) {
+				pc = in->target - 1;
+			}
+			break;
+		}
+	}
+
+	if(store_reg(&reg[0], sloc, target)) {
+		return target;
+	}
+
+	return box_reg(&reg[0]);
+}
@@ -0,0 +1,106 @@
+#ifndef COMPILE_H_INCLUDED
+#define COMPILE_H_INCLUDED
+/*
+MIT License
+
+Copyright (c) 2019 Tristan Styles
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ast.h"
+#include "builtins.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//------------------------------------------------------------------------------
+
+typedef enum {
+	LOWER_Arithmetic,
+	LOWER_Bitwise,
+	LOWER_Bitmove,
+	LOWER_Compare,
+	LOWER_LogicalAnd,
+	LOWER_LogicalOr
+} Lowering;
+
+struct builtinlowering {
+	BuiltinOp  func;
+	Lowering   lowering;
+	IntegerOp  integerop;
+	FloatOp    floatop;
+	FloatCmp   floatcmp;
+};
+extern int
+initialise_builtinlowering(
+	struct builtinlowering const builtinlowering[],
+	size_t                       n_builtinlowering
+);
+
+extern int
+initialise_builtinfolding(
+	BuiltinOp const builtinfolding[],
+	size_t          n_builtinfolding
+);
+
+//------------------------------------------------------------------------------
+
+extern Ast
+fold(
+	Ast env,
+	Ast ast
+);
+
+extern void
+compile(
+	Ast ast
+);
+
+// True when evaluating ast can only read variables: it is made of literals,
+// identifiers and the operators that compile() lowers.
+extern bool
+reads_only(
+	Ast ast
+);
+
+extern Ast
+execute(
+	Ast env,
+	Ast ast
+);
+
+// As execute(), but a number result is stored in place into target when
+// assigning it there would only overwrite its value; target is then returned.
+extern Ast
+execute_into(
+	Ast    env,
+	Ast    ast,
+	sloc_t sloc,
+	Ast    target
+);
+
+//------------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif//ndef COMPILE_H_INCLUDED
@@ -28,7 +28,7 @@ SOFTWARE.
 #include "strlib.h"
 #include "assert.h"
 #include "gc.h"
-#include "hash.h"
+#include "cache.h"
 #include <stdlib.h>
 #include <stdarg.h>
 
@@ -38,12 +38,62 @@ struct env_stats env_stats;
 
 //------------------------------------------------------------------------------
 
+static bool
+release_share(
+	Array env
+) {
+	size_t *sharers = ((struct shared_env *)env)->sharers;
+	if(sharers) {
+		((struct shared_env *)env)->sharers = NULL;
+		if(--*sharers > 0) {
+			return true;
+		}
+		free(sharers);
+	}
+	return false;
+}
+
+static void
+release_windows(
+	Array env
+) {
+	struct shared_env *se = (struct shared_env *)env;
+
+	if(se->window) {
+		if(se->window->parent) {
+			se->window->view = NULL;
+		} else {
+			free(se->window);
+		}
+		se->window = NULL;
+	}
+
+	for(struct env_window *next, *w = se->windows; w; w = next) {
+		next = w->next;
+		if(w->view) {
+			w->parent = NULL;
+		} else {
+			free(w);
+		}
+	}
+	se->windows = NULL;
+
+	return;
+}
+
+//------------------------------------------------------------------------------
+
 void
 env_gc_mark(
 	void const *p,
 	void      (*mark)(void const *)
 ) {
-	Array env = (Array)p;
+	Array                    env = (Array)p;
+	struct env_window const *w   = ((struct shared_env *)env)->window;
+	if(w) {
+		mark(w->parent);
+		return;
+	}
 	for(size_t i = marray_length(env); i-- > 0; mark(marray_at(env, Ast, i)))
 		;
 	return;
@@ -54,7 +104,10 @@ env_gc_sweep(
 	void const *p
 ) {
 	Array env = (Array)p;
-	marray_free(env);
+	release_windows(env);
+	if(!release_share(env)) {
+		marray_free(env);
+	}
 	memset(env, 0, sizeof(*env));
 	gc_free(p);
 	return;
@@ -67,44 +120,218 @@ new_env(
 	sloc_t sloc,
 	Ast    outer
 ) {
-	Array env = gc_malloc(sizeof(*env), env_gc_mark, env_gc_sweep);
-	assert(env != NULL);
-	*env = ARRAY();
+	Array env = alloc_env();
 
 	Ast ast = new_ast(sloc, AST_Environment, env, outer);
 	return ast;
 }
 
 Array
-dup_env(
-	sloc_t sloc,
-	Array  env
+alloc_env(
+	void
+) {
+	struct shared_env *env = gc_malloc(sizeof(*env), env_gc_mark, env_gc_sweep);
+	assert(env != NULL);
+	env->array   = ARRAY();
+	env->sharers = NULL;
+	env->window  = NULL;
+	env->windows = NULL;
+	return &env->array;
+}
+
+struct remap {
+	Array  arr;
+	size_t offset;
+	size_t n;
+	size_t length;
+};
+
+static int
+remap_index(
+	void    *context,
+	size_t   index,
+	uint64_t hash
+) {
+	struct remap *remap = context;
+
+	index = (index + remap->n - remap->offset) % remap->n;
+	if(index < remap->length) {
+		size_t x = marray_map_index(remap->arr, hash, index);
+		assert(x == index);
+	}
+
+	return 0;
+}
+
+static Array
+clone_env(
+	sloc_t const *sloc,
+	Array         env,
+	size_t        offset,
+	size_t        length
 ) {
-	Array new_env = gc_malloc(sizeof(*env), env_gc_mark, env_gc_sweep);
-	assert(new_env != NULL);
-	*new_env = ARRAY();
+	Array new_env = alloc_env();
 
 	size_t n        = marray_length(env);
-	bool   expanded = marray_expand(new_env, sizeof(Ast), n);
+	bool   expanded = marray_expand(new_env, sizeof(Ast), length);
 	assert(expanded);
-	new_env->length = n;
+	new_env->length = length;
 
-	for(size_t i = 0; i < n; i++) {
-		Ast ent = marray_at(env, Ast, i);
-		ent     = dup_ast(sloc, ent);
+	for(size_t i = 0; i < length; i++) {
+		Ast ent = env_element(env, (offset + i) % n);
+		ent     = dup_ast(sloc ? *sloc : ent->sloc, ent);
 		marray_at(new_env, Ast, i) = ent;
-		if(ast_isReference(ent)) {
-			size_t      len;
-			char const *cs = StringToCharLiteral(ent->m.sval, &len);
-			uint64_t    h  = memhash(cs, len, 0);
-			size_t      x  = marray_map_index(new_env, h, i);
-			assert(x == i);
+	}
+
+	if(env->map != (uintptr_t)NULL) {
+		if((offset == 0) && (length == n)) {
+			bool cloned = marray_map_clone(new_env, env);
+			assert(cloned);
+		} else {
+			struct remap remap = { new_env, offset % n, n, length };
+			marray_foreach(env, remap_index, &remap);
 		}
 	}
 
 	return new_env;
 }
 
+static void
+replace_env(
+	Array env,
+	Array copy
+) {
+	*env  = *copy;
+	*copy = ARRAY();
+	gc_free(copy);
+	gc_remember(env);
+	return;
+}
+
+Array
+dup_env(
+	sloc_t sloc,
+	Array  env
+) {
+	return clone_env(&sloc, env, 0, marray_length(env));
+}
+
+void
+clear_env(
+	Ast env
+) {
+	if(release_share(env->m.env)) {
+		*env->m.env = ARRAY();
+	}
+	unshare_env(env->m.env);
+	marray_clear(env->m.env);
+	return;
+}
+
+Array
+share_env(
+	Array env
+) {
+	struct shared_env *from = (struct shared_env *)env;
+	if(from->window) {
+		return gc_link(window_env(env, 0, marray_length(env)));
+	}
+	if(!from->sharers) {
+		from->sharers = malloc(sizeof(*from->sharers));
+		assert(from->sharers != NULL);
+		*from->sharers = 1;
+	}
+
+	struct shared_env *to = (struct shared_env *)alloc_env();
+	to->array   = from->array;
+	to->sharers = from->sharers;
+	++*to->sharers;
+
+	return gc_link(&to->array);
+}
+
+Array
+window_env(
+	Array  env,
+	size_t offset,
+	size_t length
+) {
+	struct shared_env *from = (struct shared_env *)env;
+	size_t             n    = marray_length(env);
+
+	if(from->window) {
+		Array const parent = from->window->parent;
+		size_t      pn     = marray_length(parent);
+		if((n == pn) || (offset + length <= n)) {
+			offset = (from->window->offset + offset) % pn;
+			from   = (struct shared_env *)(env = parent);
+			n      = pn;
+		}
+	}
+
+	if((length == 0) || from->window || (env->map != (uintptr_t)NULL)) {
+		return clone_env(NULL, env, offset, length);
+	}
+
+	struct env_window *w = malloc(sizeof(*w));
+	assert(w != NULL);
+	struct shared_env *to = (struct shared_env *)alloc_env();
+	to->array.length = length;
+	to->window       = w;
+	*w = (struct env_window){ from->windows, &to->array, env, offset % n };
+	from->windows    = w;
+
+	return &to->array;
+}
+
+static void
+materialise_window(
+	Array env
+) {
+	Array copy = clone_env(NULL, env, 0, marray_length(env));
+	release_windows(env);
+	replace_env(env, copy);
+	return;
+}
+
+void
+unshare_env__actual(
+	Array env
+) {
+	struct shared_env *se = (struct shared_env *)env;
+
+	if(se->windows) {
+		size_t ts = gc_topof_stack();
+		for(struct env_window *next, *w = se->windows; w; w = next) {
+			next = w->next;
+			if(w->view) {
+				materialise_window(gc_push(w->view));
+			}
+			free(w);
+		}
+		se->windows = NULL;
+		gc_revert(ts);
+	}
+
+	if(se->window) {
+		materialise_window(env);
+		return;
+	}
+
+	if(se->sharers) {
+		if(*se->sharers > 1) {
+			Array copy = clone_env(NULL, env, 0, marray_length(env));
+			release_share(env);
+			replace_env(env, copy);
+			return;
+		}
+
+		release_share(env);
+	}
+
+	return;
+}
+
 Ast
 link_env(
 	sloc_t sloc,
@@ -156,11 +383,11 @@ lookup(
 		Array  arr   = env->m.env;
 		size_t index = marray_get_index(arr, hash, cmp, leme, len);
 		if(~index) {
-			return (index < marray_length(arr)) ? (
-				marray_at(arr, Ast, index)
-			) : (
-				ZEN
-			);
+			if(index < marray_length(arr)) {
+				unshare_env(arr);
+				return marray_at(arr, Ast, index);
+			}
+			return ZEN;
 		}
 	} while((--depth != 0) && ast_isnotZen(env = env->m.rexpr))
 		;
@@ -180,7 +407,11 @@ define(
 		Array  arr   = env->m.env;
 		size_t index = marray_length(arr);
 
-		if(marray_push_back(arr, Ast, def)) {
+		unshare_env(arr);
+		if(marray_push_back(arr, Ast, gc_remember(def))) {
+			if(env == operators) {
+				operators_version++;
+			}
 			return marray_map_index(arr, hash, index);
 		}
 	}
@@ -196,7 +427,7 @@ atenv(
 	Ast ident
 ) {
 	size_t      n;
-	uint64_t    hash = ident->m.hash;
+	uint64_t    hash = ast_hash(ident);
 	char const *cs   = StringToCharLiteral(ident->m.sval, &n);
 
 	return locate(env, hash, cs, n);
@@ -208,7 +439,7 @@ inenv(
 	Ast ident
 ) {
 	size_t      n;
-	uint64_t    hash = ident->m.hash;
+	uint64_t    hash = ast_hash(ident);
 	char const *cs   = StringToCharLiteral(ident->m.sval, &n);
 
 	return lookup(env, hash, cs, n, 0);
@@ -227,6 +458,103 @@ named_inenv(
 	return inenv(env, a);
 }
 
+//------------------------------------------------------------------------------
+
+struct slot {
+	Array  arr;
+	size_t index;
+	String name;
+};
+
+static void
+slot_release(
+	void *p
+) {
+	free(p);
+}
+
+static void
+slot_gc_mark(
+	void  *p,
+	void (*gc_mark)(void const *)
+) {
+	struct slot *slot = p;
+	gc_mark(slot->name);
+	return;
+}
+
+static Ast
+slot_lookup(
+	Ast          env,
+	Ast          ident,
+	struct slot *slot
+) {
+	size_t      n;
+	uint64_t    hash = ast_hash(ident);
+	char const *cs   = StringToCharLiteral(ident->m.sval, &n);
+
+	if(ast_isnotZen(env)) do {
+		Array  arr   = env->m.env;
+		size_t index = marray_get_index(arr, hash, cmp, cs, n);
+		if(~index) {
+			if(index < marray_length(arr)) {
+				unshare_env(arr);
+				Ast ref = marray_at(arr, Ast, index);
+
+				if(ast_isReference(ref)) {
+					if(!slot) {
+						slot = malloc(sizeof(*slot));
+						if(slot && !set_ast_cache(ident, CACHE_Slot, slot, slot_release, slot_gc_mark)) {
+							free(slot);
+							slot = NULL;
+						}
+					}
+					if(slot) {
+						slot->arr   = arr;
+						slot->index = index;
+						slot->name  = ref->m.sval;
+						gc_remember(ident);
+					}
+				}
+
+				return ref;
+			}
+			return ZEN;
+		}
+	} while(ast_isnotZen(env = env->m.rexpr))
+		;
+	return ZEN;
+}
+
+Ast
+resolve(
+	Ast env,
+	Ast ident
+) {
+	struct slot *slot = ast_cache(ident, CACHE_Slot);
+
+	if(slot) for(; ast_isnotZen(env); env = env->m.rexpr) {
+		Array arr = env->m.env;
+
+		if((arr == slot->arr) || marray_has_hash(arr, ast_hash(ident))) {
+			if(slot->index < marray_length(arr)) {
+				unshare_env(arr);
+				Ast ref = marray_at(arr, Ast, slot->index);
+
+				if(ast_isReference(ref) && (ref->m.sval == slot->name)) {
+					slot->arr = arr;
+					return ref;
+				}
+			}
+			break;
+		}
+	}
+
+	return slot_lookup(env, ident, slot);
+}
+
+//------------------------------------------------------------------------------
+
 Ast
 addenv(
 	Ast    env,
@@ -239,7 +567,7 @@ addenv(
 		def->attr = (def->attr & ~ATTR_NoAssign) | attr;
 
 		size_t      n;
-		uint64_t    hash = ident->m.hash;
+		uint64_t    hash = ast_hash(ident);
 		char const *cs   = StringToCharLiteral(ident->m.sval, &n);
 		n                = locate(env, hash, cs, n);
 		if(~n == 0) {
@@ -249,6 +577,7 @@ addenv(
 			return def;
 		}
 
+		unshare_env(env->m.env);
 		ident = marray_at(env->m.env, Ast, n);
 		assign(sloc, &ident->m.rexpr, def);
 		return ident;
@@ -372,7 +701,7 @@ addenv_argv(
 		assert(s != NULL);
 		Ast    a = new_ast(sloc, AST_String, s);
 		a->attr |= ATTR_NoAssign;
-		bool   appended = marray_push_back(d->m.env, Ast, a);
+		bool   appended = marray_push_back(d->m.env, Ast, gc_remember(a));
 		assert(appended);
 	}
 
@@ -402,6 +731,8 @@ Ast globals   = NULL;
 Ast statics   = NULL;
 Ast locals    = NULL;
 
+unsigned operators_version = 0;
+
 int
 initialise_env(
 	void
@@ -430,7 +761,7 @@ Ast source_env(
 	if(!source_environments) {
 		source_environments = new_env(0, NULL);
 
-		bool appended = marray_push_back(globals->m.env, Ast, source_environments);
+		bool appended = marray_push_back(globals->m.env, Ast, gc_remember(source_environments));
 		assert(appended);
 	}
 
@@ -438,7 +769,7 @@ Ast source_env(
 	if(source == marray_length(source_environments->m.env)) {
 
 		Ast  sourcenv = new_env(make_sloc(source, 0, 0, 0), globals);
-		bool appended = marray_push_back(source_environments->m.env, Ast, sourcenv);
+		bool appended = marray_push_back(source_environments->m.env, Ast, gc_remember(sourcenv));
 		assert(appended);
 	}
 
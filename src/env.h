@@ -32,18 +32,87 @@ extern "C" {
 
 //------------------------------------------------------------------------------
 
+struct env_window {
+	struct env_window *next;
+	Array              view;
+	Array              parent;
+	size_t             offset;
+};
+
+struct shared_env {
+	struct array       array;
+	size_t            *sharers;
+	struct env_window *window;
+	struct env_window *windows;
+};
+
 extern Ast
 new_env(
 	sloc_t sloc,
 	Ast    outer
 );
 
+extern Array
+alloc_env(
+	void
+);
+
 extern Array
 dup_env(
 	sloc_t sloc,
 	Array  env
 );
 
+extern Array
+share_env(
+	Array env
+);
+
+extern Array
+window_env(
+	Array  env,
+	size_t offset,
+	size_t length
+);
+
+extern void
+unshare_env__actual(
+	Array env
+);
+static inline bool
+env_isShared(
+	Array env
+) {
+	struct shared_env const *se = (struct shared_env const *)env;
+	return se->sharers || se->window || se->windows;
+}
+static inline void
+unshare_env(
+	Array env
+) {
+	if(env_isShared(env)) {
+		unshare_env__actual(env);
+	}
+}
+
+static inline Ast
+env_element(
+	Array  env,
+	size_t index
+) {
+	struct env_window const *w = ((struct shared_env const *)env)->window;
+	if(w) {
+		size_t const n = marray_length(w->parent);
+		return marray_at(w->parent, Ast, (w->offset + index) % n);
+	}
+	return marray_at(env, Ast, index);
+}
+
+extern void
+clear_env(
+	Ast env
+);
+
 extern Ast
 link_env(
 	sloc_t sloc,
@@ -92,6 +161,12 @@ inenv(
 	Ast ident
 );
 
+extern Ast
+resolve(
+	Ast env,
+	Ast ident
+);
+
 extern Ast
 named_inenv(
 	Ast         env,
@@ -151,6 +226,8 @@ extern Ast globals;
 extern Ast statics;
 extern Ast locals;
 
+extern unsigned operators_version;
+
 int
 initialise_env(
 	void
@@ -23,27 +23,29 @@ SOFTWARE.
 */
 #include "eval.h"
 #include "env.h"
+#include "cache.h"
+#include "compile.h"
 #include "odt.h"
 #include "trace.h"
 #include "gc.h"
 
+#ifndef _WIN32
+#	include <sys/resource.h>
+#endif
+
 //------------------------------------------------------------------------------
 
 static Ast
 getref(
-	Ast      env,
-	sloc_t   sloc,
-	String   s,
-	uint64_t hash
-) {
-	size_t      n;
-	char const *cs  = StringToCharLiteral(s, &n);
-	Ast         ref = lookup(env, hash, cs, n, 0);
+	Ast env,
+	Ast ident
+) {
+	Ast ref = resolve(env, ident);
 	if(ast_isnotZen(ref)) {
 		return ref;
 	}
 
-	return oboerr(sloc, ERR_InvalidIdentifier);
+	return oboerr(ident->sloc, ERR_InvalidIdentifier);
 }
 
 //------------------------------------------------------------------------------
@@ -60,9 +62,13 @@ assign(
 		if(ast != expr) {
 			if(ast_isCopyOnAssign(ast)) {
 				*past = ast = new_ast(sloc, AST_Void);
+
+			} else if(ast->cache) {
+				drop_ast_cache(ast);
 			}
 
 			memcpy(ast, expr, sizeof(*ast));
+			gc_remember(ast);
 
 			if(ast_isRemoveCopyOnAssign(ast)) {
 				ast->attr &= ~ATTR_CopyOnAssign;
@@ -77,6 +83,311 @@ assign(
 	return oboerr(sloc, ERR_InvalidReferent);
 }
 
+bool tail_call      = false;
+Ast  tail_operator  = NULL;
+bool value_call     = false;
+Ast  value_operator = NULL;
+
+#ifdef __GNUC__
+#	define NOINLINE  __attribute__((noinline))
+#else
+#	define NOINLINE
+#endif
+
+struct frame {
+	Ast    function;
+	Ast    outer;
+	Ast    active;
+	Ast    spare;
+	size_t bound;
+	bool   operands;
+	Ast    locals;
+	Array  statics;
+};
+
+// Call frames, with the caller state they restore, live on a heap allocated
+// stack: an ordinary call costs no more native stack than it did before.
+static struct frame *frames          = NULL;
+static size_t        frames_length   = 0;
+static size_t        frames_capacity = 0;
+
+// Every call checks that the native stack below the base of evaluation
+// has room left for it, as sized by the stack limit less a sixteenth kept
+// for what one call may push before the next (its builtins and compiled
+// code, reporting the error).  The parser checks the same bound, which -d 0
+// does not lift.
+uintptr_t stack_limit      = 0;
+uintptr_t eval_stack_limit = 0;
+
+#ifdef _WIN32
+#	define EVAL_STACK_SIZE  (1024 * 1024)
+#endif
+
+void
+limit_eval_stack(
+	void const *base
+) {
+#ifdef EVAL_STACK_SIZE
+	size_t size = EVAL_STACK_SIZE;
+#else
+	struct rlimit rl;
+	if((getrlimit(RLIMIT_STACK, &rl) != 0) || (rl.rlim_cur == RLIM_INFINITY)) {
+		stack_limit      = 0;
+		eval_stack_limit = 0;
+		return;
+	}
+	size_t size = (size_t)rl.rlim_cur;
+#endif
+	size_t used = size - (size / 16);
+
+	stack_limit      = ((uintptr_t)base > used) ? (uintptr_t)base - used : 0;
+	eval_stack_limit = stack_limit;
+}
+
+static bool
+push_frame(
+	struct frame const *frame
+) {
+	if(frames_length == frames_capacity) {
+		size_t        capacity = frames_capacity ? frames_capacity * 2 : 16;
+		struct frame *p        = realloc(frames, capacity * sizeof(*p));
+		if(!p) {
+			return false;
+		}
+		frames          = p;
+		frames_capacity = capacity;
+	}
+
+	frames[frames_length++] = *frame;
+	return true;
+}
+
+static inline struct frame *
+top_frame(
+	void
+) {
+	return &frames[frames_length - 1];
+}
+
+static void
+bind(
+	Ast    to,
+	Ast    env,
+	sloc_t sloc,
+	Ast    function,
+	Ast    lexpr,
+	Ast    rexpr,
+	bool   operands
+) {
+	Ast locals_save = locals;
+	locals = to;
+
+	if(operands) {
+		addenv_operands(to, env, sloc, function->m.lexpr, lexpr, rexpr);
+	} else {
+		addenv_args(to, env, sloc, function->m.lexpr, rexpr);
+	}
+
+	locals = locals_save;
+	return;
+}
+
+// Binds the arguments into ast (a new environment when NULL) and pushes the
+// frame of the call; kept out of line so that its state is not held on the
+// native stack while the body is evaluated.
+static NOINLINE Ast
+enter(
+	Ast    env,
+	sloc_t sloc,
+	Ast    function,
+	Array  source_statics,
+	Ast    ast,
+	Ast    lexpr,
+	Ast    rexpr,
+	bool   operands
+) {
+	if(stack_exhausted(eval_stack_limit)) {
+		return oboerr(sloc, ERR_DepthExceeded);
+	}
+
+	if(!ast) {
+		ast = new_env(sloc, env);
+	}
+
+	struct frame this = {
+		function, env, ast, NULL, 0, operands, locals, statics->m.env
+	};
+
+	statics->m.env = source_statics;
+	gc_remember(statics);
+
+	bind(ast, env, sloc, function, lexpr, rexpr, operands);
+	this.bound = marray_length(ast->m.env);
+
+	if(!push_frame(&this)) {
+		statics->m.env = this.statics;
+		gc_remember(statics);
+		return oboerr(sloc, ERR_FailedOperation);
+	}
+
+	locals = ast;
+	return NULL;
+}
+
+static inline Ast
+body(
+	struct frame const *frame
+) {
+	return frame->operands ? (
+		tail_refeval(locals, frame->function->m.rexpr, !trace_enabled)
+	) : (
+		tail_eval(locals, frame->function->m.rexpr, !trace_enabled)
+	);
+}
+
+// A self tail call returns the rebound spare environment of the top frame:
+// swap it with the active one and evaluate the body again.
+static NOINLINE Ast
+tail_loop(
+	Ast ast
+) {
+	size_t ts = gc_topof_stack();
+
+	do {
+		struct frame *f = top_frame();
+		f->spare  = locals;
+		f->active = ast;
+		locals    = ast;
+		gc_return(ts, ast);
+		gc_push(f->spare);
+
+		ast = body(f);
+	} while(ast == top_frame()->spare);
+
+	return ast;
+}
+
+static inline Ast
+run(
+	void
+) {
+	Ast ast = body(top_frame());
+	if(ast == top_frame()->spare) {
+		ast = tail_loop(ast);
+	}
+
+	struct frame const *f = &frames[--frames_length];
+	locals         = f->locals;
+	statics->m.env = f->statics;
+	gc_remember(statics);
+	return ast;
+}
+
+// A self tail call may only replace the active frame when the callee
+// could not have seen anything in it beyond the (shadowed) parameters.
+static NOINLINE Ast
+rebind(
+	Ast    env,
+	sloc_t sloc,
+	Ast    function,
+	Ast    lexpr,
+	Ast    rexpr,
+	bool   operands
+) {
+	struct frame *f = top_frame();
+	if(f->spare) {
+		clear_env(f->spare);
+	} else {
+		f->spare = new_env(sloc, f->outer);
+	}
+
+	Ast spare = f->spare;
+	bind(spare, env, sloc, function, lexpr, rexpr, operands);
+	return spare;
+}
+
+static inline Ast
+call(
+	Ast    env,
+	sloc_t sloc,
+	Ast    function,
+	Array  source_statics,
+	Ast    lexpr,
+	Ast    rexpr,
+	bool   operands,
+	bool   tail
+) {
+	if(tail && frames_length
+		&& (top_frame()->function == function)
+		&& (marray_length(top_frame()->active->m.env) == top_frame()->bound)
+	) {
+		return rebind(env, sloc, function, lexpr, rexpr, operands);
+	}
+
+	Ast error = enter(env, sloc, function, source_statics, NULL, lexpr, rexpr, operands);
+	return error ? error : run();
+}
+
+Ast
+invoke(
+	Ast    env,
+	sloc_t sloc,
+	Ast    function,
+	Array  source_statics,
+	Ast    args,
+	bool   tail
+) {
+	return call(env, sloc, function, source_statics, ZEN, args, false, tail);
+}
+
+// Whether the call is in tail position is told by tail_operator, as set by
+// the operator that applies the function.
+Ast
+invoke_operator(
+	Ast    env,
+	sloc_t sloc,
+	Ast    function,
+	Array  source_statics,
+	Ast    lexpr,
+	Ast    rexpr
+) {
+	return call(env, sloc, function, source_statics, lexpr, rexpr, true, is_tail_operator(lexpr, rexpr));
+}
+
+// Applies a function to already evaluated arguments, rebinding the frame
+// left in *spare by the previous call when the callee kept nothing in it.
+Ast
+apply(
+	Ast    env,
+	sloc_t sloc,
+	Ast    function,
+	Ast    args,
+	Ast   *spare
+) {
+	Ast ast = *spare;
+	if(ast) {
+		clear_env(ast);
+	}
+	*spare = NULL;
+
+	Ast source = source_env(sloc_source(function->sloc));
+	Ast error  = enter(env, sloc, function, source->m.env, ast, ZEN, args, false);
+	if(error) {
+		return error;
+	}
+
+	ast = top_frame()->active;
+
+	size_t bound  = top_frame()->bound;
+	Ast    result = run();
+
+	if((result != ast) && (marray_length(ast->m.env) == bound)) {
+		*spare = ast;
+	}
+
+	return result;
+}
+
 Ast
 evalop(
 	Ast    env,
@@ -95,19 +406,8 @@ evalop(
 		}
 		break;
 	case AST_OperatorFunction: {
-			Array statics_env = statics->m.env;
-			Ast   locals_save = source_env(sloc_source(ast->sloc));
-			statics->m.env    = locals_save->m.env;
-
-			locals_save = locals;
-			ast = ast->m.rexpr;
-			locals = new_env(sloc, env);
-			addenv_operands(locals, env, sloc, ast->m.lexpr, lexpr, rexpr);
-			ast = refeval(locals, ast->m.rexpr);
-			locals = locals_save;
-
-			statics->m.env = statics_env;
-			return ast;
+			Ast source = source_env(sloc_source(ast->sloc));
+			return invoke_operator(env, sloc, ast->m.rexpr, source->m.env, lexpr, rexpr);
 		}
 	case AST_Error:
 		return ast;
@@ -120,12 +420,206 @@ evalop(
 
 //------------------------------------------------------------------------------
 
+struct opcache {
+	unsigned  version;
+	BuiltinOp bop;
+	Ast       function;
+	Array     statics;
+};
+
+static void
+release_opcache(
+	void *p
+) {
+	free(p);
+}
+
+static struct opcache *
+opcache(
+	Ast    ast,
+	size_t index
+) {
+	struct opcache *oc = ast_cache(ast, CACHE_Operator);
+
+	if(!oc || (oc->version != operators_version)) {
+		Ast opr = getopr(index);
+
+		if(!(ast_isBuiltinOperator(opr) && opr->m.bop)
+			&& !ast_isOperatorFunction(opr)
+		) {
+			if(oc) {
+				drop_ast_cache(ast);
+			}
+			return NULL;
+		}
+
+		if(!oc) {
+			if(ast_cache(ast, CACHE_Code)) {
+				return NULL;
+			}
+			oc = malloc(sizeof(*oc));
+			if(!oc) {
+				return NULL;
+			}
+			if(!set_ast_cache(ast, CACHE_Operator, oc, release_opcache, NULL)) {
+				free(oc);
+				return NULL;
+			}
+		}
+
+		oc->version = operators_version;
+		if(ast_isBuiltinOperator(opr)) {
+			oc->bop      = opr->m.bop;
+			oc->function = NULL;
+			oc->statics  = NULL;
+		} else {
+			oc->bop      = NULL;
+			oc->function = opr->m.rexpr;
+			oc->statics  = source_env(sloc_source(opr->sloc))->m.env;
+		}
+	}
+
+	return oc;
+}
+
+static inline Ast
+operate(
+	Ast    env,
+	Ast    ast,
+	size_t index,
+	Ast    lexpr,
+	Ast    rexpr,
+	bool   tail,
+	bool   value
+) {
+	value_operator = value ? ast : NULL;
+
+	if(ast->cache && !trace_enabled) {
+		Ast result = execute(env, ast);
+		if(result) {
+			return result;
+		}
+	}
+
+	tail_operator = tail ? ast : NULL;
+
+	struct opcache *oc = opcache(ast, index);
+	if(oc) {
+		return oc->bop ? (
+			oc->bop(env, ast->sloc, lexpr, rexpr)
+		) : (
+			invoke_operator(env, ast->sloc, oc->function, oc->statics, lexpr, rexpr)
+		);
+	}
+
+	return evalop(env, ast->sloc, index, lexpr, rexpr);
+}
+
+static inline bool
+tail_once(
+	bool *tail
+) {
+	bool t = *tail;
+	*tail  = false;
+	return t;
+}
+
+//------------------------------------------------------------------------------
+
+struct continuation {
+	Ast    ast;
+	Ast    value;
+};
+
+struct continuation_stack {
+	struct continuation *base;
+	size_t               length;
+	size_t               capacity;
+};
+
+static bool
+push_continuation(
+	struct continuation_stack *stack,
+	Ast                        ast,
+	Ast                        value
+) {
+	if(stack->length == stack->capacity) {
+		size_t               capacity = stack->capacity ? stack->capacity * 2 : 16;
+		struct continuation *p        = realloc(stack->base, capacity * sizeof(*p));
+		if(!p) {
+			return false;
+		}
+		stack->base     = p;
+		stack->capacity = capacity;
+	}
+
+	stack->base[stack->length++] = (struct continuation){ ast, value };
+	return true;
+}
+
+// Sequences nest to the right, so a long list would otherwise recurse once
+// per element: evaluate the spine in order, keeping the pending elements on
+// a heap allocated stack, then build the result from the tail back.
+static Ast
+evalsequence(
+	Ast env,
+	Ast ast
+) {
+	struct continuation_stack stack = { NULL, 0, 0 };
+
+	do {
+		Ast lexpr = gc_push(eval(env, ast->m.lexpr));
+		if(!push_continuation(&stack, ast, lexpr)) {
+			free(stack.base);
+			return oboerr(ast->sloc, ERR_FailedOperation);
+		}
+		ast = ast->m.rexpr;
+	} while(ast_isSequence(ast)
+		&& !(ast->attr & ATTR_NoEvaluate)
+		&& !trace_enabled
+	);
+
+	Ast rexpr = gc_push(eval(env, ast));
+
+	while(stack.length > 0) {
+		struct continuation const *k = &stack.base[--stack.length];
+
+		if(ast_isnotZen(k->value) && ast_isnotZen(rexpr)) {
+			rexpr = gc_push(new_ast(k->ast->sloc, AST_Sequence, k->value, rexpr));
+		} else if(ast_isnotZen(k->value)) {
+			rexpr = k->value;
+		}
+		if(stack.length > 0) {
+			rexpr->attr |= ATTR_NoEvaluate;
+		}
+	}
+
+	free(stack.base);
+	return rexpr;
+}
+
+//------------------------------------------------------------------------------
+
+size_t eval_depth       = 0;
+size_t eval_depth_limit = 0;
+
 Ast
 subeval__actual(
 	Ast env,
 	Ast ast
 ) {
+	bool tail  = tail_call;
+	bool value = value_call;
+
+	tail_call  = false;
+	value_call = false;
+
+	if(eval_depth_limit && (eval_depth >= eval_depth_limit)) {
+		return oboerr(ast->sloc, ERR_DepthExceeded);
+	}
+
 	size_t ts = gc_topof_stack();
+	eval_depth++;
 
 	for(Ast prev = ZEN; prev != ast; ) {
 		TRACE(trace_global_indent,ast);
@@ -135,18 +629,21 @@ subeval__actual(
 #	define EVAL(...)    __VA_ARGS__;
 
 #	define RETURN(...)  __VA_ARGS__; goto return_ast
-#	define REFERENCE(Ident,Hash)      getref   (env, ast->sloc, Ident, Hash)
-#	define OPERATOR(Qual,Lexpr,Rexpr) evalop   (env, ast->sloc, Qual, Lexpr, Rexpr)
+#	define REFERENCE(Ident)           getref   (env, Ident)
+#	define OPERATOR(Qual,Lexpr,Rexpr) operate  (env, ast, Qual, Lexpr, Rexpr, tail_once(&tail), tail_once(&value))
+#	define TAILEVAL(Env,Ast)          tail_eval(Env, Ast, tail_once(&tail))
 
 #	include "oboe.enum"
 
 #	undef RETURN
 #	undef REFERENCE
 #	undef OPERATOR
+#	undef TAILEVAL
 		}}
 	}
 
 return_ast:
+	eval_depth--;
 	return gc_return(ts, ast);
 }
 
@@ -168,6 +665,8 @@ eval__actual(
 	Ast env,
 	Ast ast
 ) {
+	value_call = true;
+
 	for(ast = refeval__actual(env, ast);
 		ast_isQuoted(ast);
 		ast = refeval(env, ast->m.rexpr)
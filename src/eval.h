@@ -49,6 +49,24 @@ evalop(
 	Ast    rexpr
 );
 
+extern size_t    eval_depth;
+extern size_t    eval_depth_limit;
+extern uintptr_t stack_limit;
+extern uintptr_t eval_stack_limit;
+
+extern void
+limit_eval_stack(
+	void const *base
+);
+
+static inline bool
+stack_exhausted(
+	uintptr_t limit
+) {
+	char here;
+	return (uintptr_t)&here < limit;
+}
+
 extern Ast
 subeval__actual(
 	Ast env,
@@ -118,6 +136,92 @@ evalseq(
 }
 
 
+//------------------------------------------------------------------------------
+
+extern bool tail_call;
+extern Ast  tail_operator;
+extern bool value_call;
+extern Ast  value_operator;
+
+static inline bool
+is_tail_operator(
+	Ast lexpr,
+	Ast rexpr
+) {
+	return tail_operator
+		&& (tail_operator->m.lexpr == lexpr)
+		&& (tail_operator->m.rexpr == rexpr);
+}
+
+static inline bool
+is_value_operator(
+	Ast lexpr,
+	Ast rexpr
+) {
+	return value_operator
+		&& (value_operator->m.lexpr == lexpr)
+		&& (value_operator->m.rexpr == rexpr);
+}
+
+static inline Ast
+tail_eval(
+	Ast  env,
+	Ast  ast,
+	bool tail
+) {
+	if(ast->attr & ATTR_NoEvaluate) {
+		return ast;
+	}
+
+	tail_call = tail;
+	return eval__actual(env, ast);
+}
+
+static inline Ast
+tail_refeval(
+	Ast  env,
+	Ast  ast,
+	bool tail
+) {
+	if(ast->attr & ATTR_NoEvaluate) {
+		return ast;
+	}
+
+	tail_call = tail;
+	return refeval__actual(env, ast);
+}
+
+extern Ast
+invoke(
+	Ast    env,
+	sloc_t sloc,
+	Ast    function,
+	Array  source_statics,
+	Ast    args,
+	bool   tail
+);
+
+extern Ast
+invoke_operator(
+	Ast    env,
+	sloc_t sloc,
+	Ast    function,
+	Array  source_statics,
+	Ast    lexpr,
+	Ast    rexpr
+);
+
+extern Ast
+apply(
+	Ast    env,
+	sloc_t sloc,
+	Ast    function,
+	Ast    args,
+	Ast   *spare
+);
+
+//------------------------------------------------------------------------------
+
 extern Ast
 eval_named(
 	Ast         env,
@@ -23,7 +23,11 @@ SOFTWARE.
 */
 #include "gc.h"
 #include "bitmac.h"
+#include "bits.h"
 #include <string.h>
+#ifdef GC_VERIFY
+#include <stdio.h>
+#endif
 
 //------------------------------------------------------------------------------
 
@@ -34,17 +38,138 @@ struct gc {
 	void    (*sweep)(void const *ptr);
 };
 
+// Objects of a class have no header: they are allocated from pages holding
+// objects of one size, and their state is kept in bitmaps indexed by their
+// slot in the page.
+struct gc_class {
+	size_t          size;
+	unsigned        shift;
+	size_t          words;
+	void          (*mark )(void const *ptr, void (*gc_mark)(void const *));
+	void          (*sweep)(void const *ptr);
+	struct gc_page *avail;
+};
+
+struct gc_page {
+	uintptr_t        base;
+	struct gc_class *type;
+	unsigned         shift;
+	size_t           words;
+	size_t           used;
+	size_t           next;
+	struct gc_page  *avail;
+	struct gc_page  *young_next;
+	bool             listed;
+	bool             young;
+	bool             unswept;
+	size_t           bitmap[];
+};
+
+enum gc_bitmap {
+	GC_BITMAP_ALLOCATED,
+	GC_BITMAP_LINKED,
+	GC_BITMAP_OLD,
+	GC_BITMAP_SCANNED,
+	GC_BITMAP_MARKED,
+	GC_BITMAP_REMEMBERED,
+	GC_BITMAP_VERIFIED,
+	GC_BITMAPS
+};
+
 //------------------------------------------------------------------------------
 
 #define GC_MIN  BIT_ROUND(sizeof(struct gc))
 #define GC_MAX  (BIT_ROUND(SIZE_MAX/2) - GC_MIN)
 #define GC_TAG  ((uintptr_t)0x3)
 
-static struct gc_stats _gc_stats =  { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+// The low bits of a block size are free, and hold its generation, whether
+// it is in the remembered set, and whether it is marked by the current
+// collection of the old generation.
+#define GC_OLD         ((size_t)0x1)
+#define GC_REMEMBERED  ((size_t)0x2)
+#define GC_VERIFIED    ((size_t)0x4)
+#define GC_MARKED      ((size_t)0x8)
+#define GC_FLAGS       (GC_OLD | GC_REMEMBERED | GC_VERIFIED | GC_MARKED)
+
+// Pages are aligned to their size, and are carved out of chunks of
+// GC_PAGE_CHUNK pages; they are found from an address through a two level
+// map of page numbers, which covers 48 bit addresses.
+#define GC_PAGE_SHIFT  16
+#define GC_PAGE_SIZE   ((size_t)1 << GC_PAGE_SHIFT)
+#define GC_PAGE_CHUNK  16
+#define GC_BITS        (sizeof(size_t) * CHAR_BIT)
+#define GC_CLASS_MIN   ((size_t)16)
+#define GC_CLASS_MAX   (GC_PAGE_SIZE / GC_BITS)
+#if UINTPTR_MAX > UINT32_MAX
+#	define GC_PAGE_MAP_BITS  16
+#else
+#	define GC_PAGE_MAP_BITS  8
+#endif
+#define GC_PAGE_MAP_SIZE  ((size_t)1 << GC_PAGE_MAP_BITS)
+
+#ifdef __GNUC__
+#	define GC_TZCOUNT(X)   __builtin_ctzll((X))
+#	define GC_POPCOUNT(X)  __builtin_popcountll((X))
+#else
+#	define GC_TZCOUNT(X)   tzcountz((X))
+#	define GC_POPCOUNT(X)  popcountz((X))
+#endif
+
+// While a grey stack is drained, the objects it reaches are visited this
+// many objects late, and objects are taken off it this far ahead of being
+// scanned, so that either can be prefetched.
+#define GC_PREFETCH_DISTANCE  8
+
+#ifdef __GNUC__
+#	define GC_PREFETCH(Ptr)  __builtin_prefetch((Ptr))
+#else
+#	define GC_PREFETCH(Ptr)  ((void)(Ptr))
+#endif
+
+enum gc_phase {
+	GC_IDLE,
+	GC_MARKING,
+	GC_SWEEPING
+};
+
+struct gc_grey {
+	size_t       size;
+	size_t       depth;
+	void const **stack;
+	bool         draining;
+	size_t       deferred;
+	void const  *defer[GC_PREFETCH_DISTANCE];
+};
+
+static struct gc_stats _gc_stats =  { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
 static size_t       _gc_sizeof_stack = 0;
 static void const **_gc_stack        = NULL;
 static uintptr_t    _gc_list         = ((uintptr_t)NULL & ~GC_TAG) | 0x1;
+static uintptr_t    _gc_young        = (uintptr_t)NULL;
+static uintptr_t    _gc_epoch        = 0x1;
+static size_t       _gc_young_from   = 0;
+
+static size_t       _gc_sizeof_remembered = 0;
+static size_t       _gc_n_remembered      = 0;
+static void const **_gc_remembered        = NULL;
+static bool         _gc_overflow          = false;
+
+static size_t           _gc_sizeof_pages = 0;
+static size_t           _gc_n_pages      = 0;
+static struct gc_page **_gc_pages        = NULL;
+static struct gc_page **_gc_page_map[GC_PAGE_MAP_SIZE];
+static char            *_gc_chunk        = NULL;
+static size_t           _gc_chunk_pages  = 0;
+static struct gc_page  *_gc_young_pages  = NULL;
+static size_t           _gc_sweep_next   = 0;
+static size_t           _gc_sweep_end    = 0;
+
+static enum gc_phase  _gc_phase      = GC_IDLE;
+static struct gc_grey _gc_grey       = { 0, 0, NULL, false, 0, { NULL } };
+static struct gc_grey _gc_grey_young = { 0, 0, NULL, false, 0, { NULL } };
+static uintptr_t      _gc_sweeping   = (uintptr_t)NULL;
+static size_t         _gc_work       = 0;
 
 //------------------------------------------------------------------------------
 
@@ -74,6 +199,13 @@ _gc(
 	return (struct gc *)ptr;
 }
 
+static inline size_t
+_gc_size(
+	void const *ptr
+) {
+	return _gc(ptr)->size & ~GC_FLAGS;
+}
+
 static inline void *
 _gc_wrap(
 	void const *ptr
@@ -88,6 +220,151 @@ _gc_unwrap(
 	return (void *)((char *)ptr - GC_MIN);
 }
 
+//------------------------------------------------------------------------------
+
+static inline struct gc_page *
+_gc_page_of(
+	void const *ptr
+) {
+	uintptr_t const n = (uintptr_t)ptr >> GC_PAGE_SHIFT;
+	if(n >= ((uintptr_t)GC_PAGE_MAP_SIZE * GC_PAGE_MAP_SIZE)) {
+		return NULL;
+	}
+
+	struct gc_page **leaf = _gc_page_map[n / GC_PAGE_MAP_SIZE];
+
+	return leaf ? leaf[n % GC_PAGE_MAP_SIZE] : NULL;
+}
+
+static inline struct gc_page **
+_gc_page_entry(
+	uintptr_t base
+) {
+	uintptr_t const n = base >> GC_PAGE_SHIFT;
+	if(n >= ((uintptr_t)GC_PAGE_MAP_SIZE * GC_PAGE_MAP_SIZE)) {
+		return NULL;
+	}
+
+	struct gc_page ***leaf = &_gc_page_map[n / GC_PAGE_MAP_SIZE];
+	if(!*leaf && !(*leaf = (calloc)(GC_PAGE_MAP_SIZE, sizeof((*leaf)[0])))) {
+		return NULL;
+	}
+
+	return &(*leaf)[n % GC_PAGE_MAP_SIZE];
+}
+
+// The bitmaps are interleaved, so that the bits of an object share a
+// cache line.
+static inline size_t *
+_gc_bits(
+	struct gc_page *page,
+	size_t          word
+) {
+	return &page->bitmap[word * GC_BITMAPS];
+}
+
+static inline size_t
+_gc_slot(
+	struct gc_page const *page,
+	void const           *ptr
+) {
+	return ((uintptr_t)ptr - page->base) >> page->shift;
+}
+
+static inline void *
+_gc_slot_ptr(
+	struct gc_page const *page,
+	size_t                slot
+) {
+	return (void *)(page->base + ((uintptr_t)slot << page->shift));
+}
+
+static inline bool
+_gc_bit(
+	struct gc_page *page,
+	enum gc_bitmap  map,
+	size_t          slot
+) {
+	return (_gc_bits(page, slot / GC_BITS)[map] >> (slot % GC_BITS)) & 1;
+}
+
+static inline void
+_gc_bit_set(
+	struct gc_page *page,
+	enum gc_bitmap  map,
+	size_t          slot
+) {
+	_gc_bits(page, slot / GC_BITS)[map] |= (size_t)1 << (slot % GC_BITS);
+}
+
+static inline void
+_gc_bit_clear(
+	struct gc_page *page,
+	enum gc_bitmap  map,
+	size_t          slot
+) {
+	_gc_bits(page, slot / GC_BITS)[map] &= ~((size_t)1 << (slot % GC_BITS));
+}
+
+static struct gc_page *
+_gc_new_page(
+	struct gc_class *type
+) {
+	if(_gc_n_pages == _gc_sizeof_pages) {
+		if(_gc_sizeof_pages > (GC_MAX / sizeof(_gc_pages[0]))) {
+			return NULL;
+		}
+
+		size_t           new_sizeof_pages = _gc_sizeof_pages ? (_gc_sizeof_pages * 2) : GC_MIN;
+		struct gc_page **new_pages        = (realloc)(_gc_pages, new_sizeof_pages * sizeof(_gc_pages[0]));
+		if(!new_pages) {
+			return NULL;
+		}
+		_gc_pages        = new_pages;
+		_gc_sizeof_pages = new_sizeof_pages;
+	}
+
+	if(_gc_chunk_pages == 0) {
+		char *chunk = (malloc)(GC_PAGE_SIZE * (GC_PAGE_CHUNK + 1));
+		if(!chunk) {
+			return NULL;
+		}
+		_gc_chunk       = (char *)(((uintptr_t)chunk + (GC_PAGE_SIZE - 1)) & ~(uintptr_t)(GC_PAGE_SIZE - 1));
+		_gc_chunk_pages = GC_PAGE_CHUNK + (_gc_chunk == chunk);
+	}
+
+	struct gc_page **entry = _gc_page_entry((uintptr_t)_gc_chunk);
+	if(!entry) {
+		return NULL;
+	}
+
+	size_t const    size = sizeof(struct gc_page) + (GC_BITMAPS * type->words * sizeof(size_t));
+	struct gc_page *page = (malloc)(size);
+	if(!page) {
+		return NULL;
+	}
+	memset(page, 0, size);
+
+	page->base  = (uintptr_t)_gc_chunk;
+	page->type  = type;
+	page->shift = type->shift;
+	page->words = type->words;
+
+	_gc_chunk += GC_PAGE_SIZE;
+	_gc_chunk_pages--;
+
+	_gc_pages[_gc_n_pages++] = page;
+	*entry                   = page;
+
+	page->listed = true;
+	page->avail  = type->avail;
+	type->avail  = page;
+
+	return page;
+}
+
+//------------------------------------------------------------------------------
+
 static inline void
 _gc_push(
 	void const *ptr
@@ -112,29 +389,326 @@ _gc_push(
 	return;
 }
 
-static inline void *
+static inline void const *
 _gc_link(
-	void *ptr
+	void const *ptr
 ) {
-	if(_gc(ptr)->link == 0) {
-		_gc(ptr)->link = _gc_list;
-		_gc_list       = ((uintptr_t)ptr & ~GC_TAG) | (_gc_list & GC_TAG);
+	struct gc_page *page = _gc_page_of(ptr);
+	if(page) {
+		size_t const slot = _gc_slot(page, ptr);
+		if(!_gc_bit(page, GC_BITMAP_LINKED, slot)) {
+			_gc_bit_set(page, GC_BITMAP_LINKED, slot);
+			if(!page->young) {
+				page->young      = true;
+				page->young_next = _gc_young_pages;
+				_gc_young_pages  = page;
+			}
+		}
+		return ptr;
+	}
+
+	struct gc *gc = _gc_unwrap(ptr);
+	if(gc->link == 0) {
+		gc->link   = _gc_young | (_gc_list & GC_TAG);
+		_gc_young  = (uintptr_t)gc & ~GC_TAG;
 	}
 	return ptr;
 }
 
+static bool
+_gc_remembered_push(
+	void const *ptr
+) {
+	if((_gc_n_remembered == _gc_sizeof_remembered)
+		&& (_gc_sizeof_remembered <= GC_MAX)
+	) {
+		size_t       new_sizeof_remembered = _gc_sizeof_remembered ? (_gc_sizeof_remembered * 2) : GC_MIN;
+		void const **new_remembered        = (realloc)(_gc_remembered, new_sizeof_remembered * sizeof(_gc_remembered[0]));
+		if(!new_remembered) {
+			_gc_overflow = true;
+			return false;
+		}
+		_gc_remembered        = new_remembered;
+		_gc_sizeof_remembered = new_sizeof_remembered;
+	}
+
+	_gc_remembered[_gc_n_remembered++] = ptr;
+
+	return true;
+}
+
+static inline void
+_gc_remember(
+	void const *ptr
+) {
+	struct gc_page *page = _gc_page_of(ptr);
+	if(page) {
+		size_t const slot = _gc_slot(page, ptr);
+		if(_gc_bit(page, GC_BITMAP_LINKED, slot)
+			&& !_gc_bit(page, GC_BITMAP_REMEMBERED, slot)
+			&& _gc_remembered_push(ptr)
+		) {
+			_gc_bit_set(page, GC_BITMAP_REMEMBERED, slot);
+		}
+		return;
+	}
+
+	struct gc *gc = _gc_unwrap(ptr);
+	if(gc->link
+		&& !(gc->size & GC_REMEMBERED)
+		&& _gc_remembered_push(ptr)
+	) {
+		gc->size |= GC_REMEMBERED;
+	}
+
+	return;
+}
+
+// Scans an object, returning its size.
+static inline size_t
+_gc_trace(
+	void const *ptr,
+	void      (*callback)(void const *)
+) {
+	struct gc_page *page = _gc_page_of(ptr);
+	if(page) {
+		page->type->mark(ptr, callback);
+		return page->type->size;
+	}
+
+	struct gc *gc = _gc_unwrap(ptr);
+	gc->mark(ptr, callback);
+	return _gc_size(gc);
+}
+
+static inline bool
+_gc_grey_push(
+	struct gc_grey *grey,
+	void const     *ptr
+) {
+	if(grey->depth == grey->size) {
+		if(grey->size > GC_MAX) {
+			return false;
+		}
+
+		size_t       new_size  = grey->size ? (grey->size * 2) : GC_MIN;
+		void const **new_stack = (realloc)(grey->stack, new_size * sizeof(grey->stack[0]));
+		if(!new_stack) {
+			return false;
+		}
+		grey->stack = new_stack;
+		grey->size  = new_size;
+	}
+
+	grey->stack[grey->depth++] = ptr;
+
+	return true;
+}
+
+static inline void
+_gc_grey_add(
+	struct gc_grey *grey,
+	void const     *ptr,
+	void          (*callback)(void const *)
+) {
+	if(!_gc_grey_push(grey, ptr)) {
+		_gc_trace(ptr, callback);
+	}
+
+	return;
+}
+
+static inline void const *
+_gc_grey_defer(
+	struct gc_grey *grey,
+	void const     *ptr
+) {
+	if(!grey->draining) {
+		return ptr;
+	}
+
+	GC_PREFETCH(ptr);
+
+	void const *next = grey->defer[grey->deferred];
+	grey->defer[grey->deferred] = ptr;
+	grey->deferred = (grey->deferred + 1) % GC_PREFETCH_DISTANCE;
+
+	return next;
+}
+
+static inline void
+_gc_grey_undefer(
+	struct gc_grey *grey,
+	void          (*visit)(void const *)
+) {
+	for(size_t i = 0; i < GC_PREFETCH_DISTANCE; i++) {
+		void const *ptr = grey->defer[i];
+		if(ptr) {
+			grey->defer[i] = NULL;
+			visit(ptr);
+		}
+	}
+
+	return;
+}
+
+// Scans grey objects until the stack is empty or the budget is spent;
+// should the stack be unable to grow the objects are scanned in place.
+static void
+_gc_grey_drain(
+	struct gc_grey *grey,
+	size_t          budget,
+	void          (*callback)(void const *),
+	void          (*visit)(void const *)
+) {
+	void const *queue[GC_PREFETCH_DISTANCE];
+	size_t      head  = 0;
+	size_t      count = 0;
+
+	grey->draining = true;
+
+	while(_gc_work < budget) {
+		if((grey->depth == 0) && (count == 0)) {
+			_gc_grey_undefer(grey, visit);
+		}
+		for(; (count < GC_PREFETCH_DISTANCE) && (grey->depth > 0); count++) {
+			void const *ptr = grey->stack[--grey->depth];
+			GC_PREFETCH(ptr);
+			queue[(head + count) % GC_PREFETCH_DISTANCE] = ptr;
+		}
+		if(count == 0) {
+			break;
+		}
+
+		void const *ptr = queue[head];
+		head  = (head + 1) % GC_PREFETCH_DISTANCE;
+		count--;
+
+		_gc_work += _gc_trace(ptr, callback);
+	}
+
+	grey->draining = false;
+
+	_gc_grey_undefer(grey, visit);
+
+	while(count-- > 0) {
+		_gc_grey_add(grey, queue[(head + count) % GC_PREFETCH_DISTANCE], callback);
+	}
+
+	return;
+}
+
+static void
+_gc_shade_callback(
+	void const *ptr
+);
+
+static void
+_gc_shade(
+	void const *ptr
+) {
+	struct gc_page *page = _gc_page_of(ptr);
+	if(page) {
+		size_t const slot = _gc_slot(page, ptr);
+		if(!_gc_bit(page, GC_BITMAP_OLD, slot)
+			|| _gc_bit(page, GC_BITMAP_MARKED, slot)
+		) {
+			return;
+		}
+		_gc_bit_set(page, GC_BITMAP_MARKED, slot);
+
+	} else {
+		struct gc *gc = _gc_unwrap(ptr);
+		if((gc->size & (GC_OLD | GC_MARKED)) != GC_OLD) {
+			return;
+		}
+		gc->size |= GC_MARKED;
+	}
+
+	_gc_grey_add(&_gc_grey, ptr, _gc_shade_callback);
+
+	return;
+}
+
+static void
+_gc_shade_callback(
+	void const *ptr
+) {
+	_gc_work += sizeof(ptr);
+
+	if(!ptr) {
+		return;
+	}
+
+	void const *next = _gc_grey_defer(&_gc_grey, ptr);
+	if(next) {
+		_gc_shade(next);
+	}
+
+	return;
+}
+
 static void
 _gc_mark_callback(
 	void const *ptr
 );
 
 static inline void
+_gc_scan(
+	void const *ptr
+) {
+	struct gc_page *page = _gc_page_of(ptr);
+	if(page) {
+		size_t const slot = _gc_slot(page, ptr);
+		if(_gc_bit(page, GC_BITMAP_SCANNED, slot)) {
+			return;
+		}
+		_gc_bit_set(page, GC_BITMAP_SCANNED, slot);
+
+	} else {
+		struct gc *gc = _gc_unwrap(ptr);
+		if(!((_gc_epoch ^ gc->link) & GC_TAG)) {
+			return;
+		}
+		gc->link ^= GC_TAG;
+	}
+
+	_gc_grey_add(&_gc_grey_young, ptr, _gc_mark_callback);
+
+	return;
+}
+
+// Old objects are not traced by a young collection, but they are shaded
+// while the old generation is being marked, as they may be referenced only
+// from young objects that are about to be promoted.
+static void
 _gc_mark(
 	void const *ptr
 ) {
-	if((_gc_list ^ _gc(ptr)->link) & GC_TAG) {
-		_gc(ptr)->link ^= GC_TAG;
-		_gc(ptr)->mark(_gc_wrap(ptr), _gc_mark_callback);
+	struct gc_page *page = _gc_page_of(ptr);
+	if(page) {
+		size_t const slot = _gc_slot(page, ptr);
+		if(!_gc_bit(page, GC_BITMAP_OLD, slot)) {
+			if(!_gc_bit(page, GC_BITMAP_SCANNED, slot)) {
+				_gc_bit_set(page, GC_BITMAP_SCANNED, slot);
+				_gc_grey_add(&_gc_grey_young, ptr, _gc_mark_callback);
+			}
+			return;
+		}
+
+	} else {
+		struct gc *gc = _gc_unwrap(ptr);
+		if(!(gc->size & GC_OLD)) {
+			if((_gc_epoch ^ gc->link) & GC_TAG) {
+				gc->link ^= GC_TAG;
+				_gc_grey_add(&_gc_grey_young, ptr, _gc_mark_callback);
+			}
+			return;
+		}
+	}
+
+	if(_gc_phase == GC_MARKING) {
+		_gc_shade(ptr);
 	}
 
 	return;
@@ -148,7 +722,10 @@ _gc_mark_callback(
 		return;
 	}
 
-	_gc_mark(_gc_unwrap(ptr));
+	void const *next = _gc_grey_defer(&_gc_grey_young, ptr);
+	if(next) {
+		_gc_mark(next);
+	}
 
 	return;
 }
@@ -225,6 +802,38 @@ _gc_stats_remove_object(
 	_gc_stats.object_died++;
 }
 
+static void
+_gc_page_release(
+	struct gc_page *page,
+	size_t          word,
+	size_t          vacated
+) {
+	if(!vacated) {
+		return;
+	}
+
+	size_t const count = GC_POPCOUNT(vacated);
+
+	_gc_bits(page, word)[GC_BITMAP_ALLOCATED] &= ~vacated;
+	if(page->next > word) {
+		page->next = word;
+	}
+	page->used -= count;
+
+	if(!page->listed) {
+		page->listed      = true;
+		page->avail       = page->type->avail;
+		page->type->avail = page;
+	}
+
+	_gc_stats.size             -= count * page->type->size;
+	_gc_stats.size_deallocated += count * page->type->size;
+	_gc_stats.object_live      -= count;
+	_gc_stats.object_died      += count;
+
+	return;
+}
+
 //------------------------------------------------------------------------------
 
 void *
@@ -283,13 +892,18 @@ gc_realloc(
 		return gc_malloc(size, mark, sweep);
 	}
 
+	struct gc_page *page = _gc_page_of(ptr);
+	if(page) {
+		return (size <= page->type->size) ? (void *)ptr : NULL;
+	}
+
 	ptr = _gc_unwrap(ptr);
 
 	size += !size;
 	if(_gc_in_limit(1, size)
 		&& (_gc(ptr)->link == 0)
 	) {
-		size_t oldz = _gc(ptr)->size;
+		size_t oldz = _gc_size(ptr);
 		size        = _gc_rounded_size(size);
 		if(oldz == size) {
 			return _gc_wrap(ptr);
@@ -318,11 +932,21 @@ gc_free(
 	void const *ptr
 ) {
 	if(ptr) {
+		struct gc_page *page = _gc_page_of(ptr);
+		if(page) {
+			size_t const  slot = _gc_slot(page, ptr);
+			size_t const  word = slot / GC_BITS;
+			size_t const  bit  = (size_t)1 << (slot % GC_BITS);
+			size_t const *bits = _gc_bits(page, word);
+			_gc_page_release(page, word, bit & bits[GC_BITMAP_ALLOCATED] & ~bits[GC_BITMAP_LINKED]);
+			return;
+		}
+
 		ptr = _gc_unwrap(ptr);
 		if(_gc(ptr)->link == 0) {
 			_gc(ptr)->mark  = _gc_no_mark;
 			_gc(ptr)->sweep = _gc_no_sweep;
-			_gc_stats_remove_object(_gc(ptr)->size);
+			_gc_stats_remove_object(_gc_size(ptr));
 			(free)((void *)ptr);
 		}
 	}
@@ -366,13 +990,78 @@ gc_pfree(
 		if(_gc(ptr)->link == 0) {
 			_gc(ptr)->mark  = _gc_no_mark;
 			_gc(ptr)->sweep = _gc_no_sweep;
-			_gc_stats_remove_object(_gc(ptr)->size);
+			_gc_stats_remove_object(_gc_size(ptr));
 		}
 	}
 
 	return (void *)ptr;
 }
 
+// Objects of a class are rounded up to a power of two; their sweep must
+// not free them, as their slot is reclaimed once it returns.
+struct gc_class *
+gc_new_class(
+	size_t size,
+	void (*mark )(void const *ptr, void (*gc_mark)(void const *)),
+	void (*sweep)(void const *ptr)
+) {
+	unsigned shift = msbitz(GC_CLASS_MIN - 1);
+	while(((size_t)1 << shift) < size) {
+		shift++;
+	}
+	if(((size_t)1 << shift) > GC_CLASS_MAX) {
+		return NULL;
+	}
+
+	struct gc_class *type = (malloc)(sizeof(*type));
+	if(type) {
+		type->size  = (size_t)1 << shift;
+		type->shift = shift;
+		type->words = (GC_PAGE_SIZE >> shift) / GC_BITS;
+		type->mark  = mark  ? mark  : _gc_no_mark;
+		type->sweep = sweep ? sweep : _gc_no_sweep;
+		type->avail = NULL;
+	}
+
+	return type;
+}
+
+void *
+gc_class_malloc(
+	struct gc_class *type
+) {
+	struct gc_page *page;
+
+	while((page = type->avail) && (page->used == (page->words * GC_BITS))) {
+		type->avail  = page->avail;
+		page->listed = false;
+	}
+	if(!_gc_in_limit(1, type->size)
+		|| (!page && !(page = _gc_new_page(type)))
+	) {
+		return NULL;
+	}
+
+	size_t  word = page->next;
+	size_t *bits;
+	size_t  vacant;
+	while(!(vacant = ~(bits = _gc_bits(page, word))[GC_BITMAP_ALLOCATED])) {
+		word++;
+	}
+	page->next = word;
+
+	vacant &= -vacant;
+	bits[GC_BITMAP_ALLOCATED] |=  vacant;
+	bits[GC_BITMAP_SCANNED]   &= ~vacant;
+	page->used++;
+
+	size_t const slot = (word * GC_BITS) + GC_TZCOUNT(vacant);
+
+	_gc_stats_add_object(type->size);
+
+	return _gc_slot_ptr(page, slot);
+}
+
 size_t
 _gc_sizeof(
 	size_t size
@@ -388,9 +1077,14 @@ gc_size(
 		return 0;
 	}
 
+	struct gc_page *page = _gc_page_of(ptr);
+	if(page) {
+		return page->type->size;
+	}
+
 	ptr = _gc_unwrap(ptr);
 
-	return _gc(ptr)->size - GC_MIN;
+	return _gc_size(ptr) - GC_MIN;
 }
 
 //------------------------------------------------------------------------------
@@ -438,7 +1132,7 @@ gc_push(
 		return (void *)ptr;
 	}
 
-	_gc_push(_gc_link(_gc_unwrap(ptr)));
+	_gc_push(_gc_link(ptr));
 
 	return (void *)ptr;
 }
@@ -451,7 +1145,7 @@ gc_link(
 		return (void *)ptr;
 	}
 
-	_gc_link(_gc_unwrap(ptr));
+	_gc_link(ptr);
 
 	return (void *)ptr;
 }
@@ -464,35 +1158,535 @@ gc_unlink(
 	(void)ptr;
 }
 
-void
-gc_mark_and_sweep(
+// Called when ptr has been written to, or has been stored somewhere the
+// next young collection might not look, so that it is scanned as a root.
+void *
+gc_remember(
+	void const *ptr
+) {
+	if(!ptr) {
+		return (void *)ptr;
+	}
+
+	_gc_remember(ptr);
+
+	return (void *)ptr;
+}
+
+size_t
+gc_young_size(
 	void
 ) {
-	if((_gc_list & ~GC_TAG) == (uintptr_t)NULL) {
-		return;
+	return _gc_stats.size_allocated - _gc_young_from;
+}
+
+//------------------------------------------------------------------------------
+
+#ifdef GC_VERIFY
+static size_t       _gc_sizeof_verified = 0;
+static size_t       _gc_n_verified      = 0;
+static void const **_gc_verified        = NULL;
+static bool         _gc_verifying_old   = false;
+
+static void
+_gc_verify_callback(
+	void const *ptr
+);
+
+static void
+_gc_verify(
+	void const *ptr
+) {
+	bool linked, unmarked;
+
+	struct gc_page *page = _gc_page_of(ptr);
+	if(page) {
+		size_t const slot = _gc_slot(page, ptr);
+		if(_gc_bit(page, GC_BITMAP_VERIFIED, slot)) {
+			return;
+		}
+		_gc_bit_set(page, GC_BITMAP_VERIFIED, slot);
+
+		linked   = _gc_bit(page, GC_BITMAP_LINKED, slot);
+		unmarked = _gc_verifying_old
+			? !_gc_bit(page, GC_BITMAP_MARKED, slot)
+			: (!_gc_bit(page, GC_BITMAP_OLD, slot) && !_gc_bit(page, GC_BITMAP_SCANNED, slot))
+		;
+
+	} else {
+		struct gc *gc = _gc_unwrap(ptr);
+		if(gc->size & GC_VERIFIED) {
+			return;
+		}
+		gc->size |= GC_VERIFIED;
+
+		linked   = gc->link != 0;
+		unmarked = _gc_verifying_old
+			? !(gc->size & GC_MARKED)
+			: (!(gc->size & GC_OLD) && ((_gc_epoch ^ gc->link) & GC_TAG))
+		;
+	}
+
+	if(_gc_n_verified == _gc_sizeof_verified) {
+		_gc_sizeof_verified = _gc_sizeof_verified ? (_gc_sizeof_verified * 2) : GC_MIN;
+		_gc_verified        = (realloc)(_gc_verified, _gc_sizeof_verified * sizeof(_gc_verified[0]));
+		if(!_gc_verified) {
+			abort();
+		}
+	}
+	_gc_verified[_gc_n_verified++] = ptr;
+
+	if(linked && unmarked) {
+		fprintf(stderr, "gc: %s object %p is reachable but was not marked\n", _gc_verifying_old ? "old" : "young", ptr);
+		abort();
+	}
+
+	return;
+}
+
+static void
+_gc_verify_callback(
+	void const *ptr
+) {
+	if(ptr) {
+		_gc_verify(ptr);
 	}
 
-	uintptr_t const tag = (_gc_list ^= GC_TAG) & GC_TAG;
+	return;
+}
+
+// Checks that every young object, or once the old generation has been
+// marked every object, reachable from the stack was marked, which fails
+// when a write site is missing its gc_remember.
+static void
+_gc_verify_marked(
+	bool old
+) {
+	_gc_verifying_old = old;
 
 	for(size_t i = _gc_stats.stack_depth; i-- > 0; ) {
-		_gc_mark(_gc_stack[i]);
+		_gc_verify(_gc_stack[i]);
+	}
+	for(size_t i = 0; i < _gc_n_verified; i++) {
+		_gc_trace(_gc_verified[i], _gc_verify_callback);
+	}
+
+	while(_gc_n_verified > 0) {
+		void const     *ptr  = _gc_verified[--_gc_n_verified];
+		struct gc_page *page = _gc_page_of(ptr);
+		if(page) {
+			_gc_bit_clear(page, GC_BITMAP_VERIFIED, _gc_slot(page, ptr));
+		} else {
+			_gc(_gc_unwrap(ptr))->size &= ~GC_VERIFIED;
+		}
+	}
+
+	return;
+}
+#endif
+
+//------------------------------------------------------------------------------
+
+// Sweeps the dead objects of a word of a page; a sweep may free other
+// objects, though only those that are not linked.
+static void
+_gc_sweep_word(
+	struct gc_page *page,
+	size_t          word,
+	size_t          dead
+) {
+	size_t *const bits = _gc_bits(page, word);
+
+	for(size_t next = dead; next; next &= next - 1) {
+		size_t const bit = next & -next;
+		bits[GC_BITMAP_LINKED] &= ~bit;
+		page->type->sweep(_gc_slot_ptr(page, (word * GC_BITS) + GC_TZCOUNT(bit)));
+	}
+
+	bits[GC_BITMAP_OLD]        &= ~dead;
+	bits[GC_BITMAP_SCANNED]    &= ~dead;
+	bits[GC_BITMAP_MARKED]     &= ~dead;
+	bits[GC_BITMAP_REMEMBERED] &= ~dead;
+
+	_gc_page_release(page, word, dead & bits[GC_BITMAP_ALLOCATED]);
+
+	return;
+}
+
+// Young objects that were scanned survive and are promoted, marked if the
+// old generation is being marked or the page has still to be swept.
+static void
+_gc_sweep_young_page(
+	struct gc_page *page
+) {
+	bool const mark = (_gc_phase == GC_MARKING) || page->unswept;
+
+	for(size_t word = 0; word < page->words; word++) {
+		size_t *const bits  = _gc_bits(page, word);
+		size_t  const young = bits[GC_BITMAP_LINKED] & ~bits[GC_BITMAP_OLD];
+		size_t  const live  = young & bits[GC_BITMAP_SCANNED];
+
+		bits[GC_BITMAP_OLD]     |= live;
+		bits[GC_BITMAP_SCANNED]  = 0;
+		if(mark) {
+			bits[GC_BITMAP_MARKED] |= live;
+		}
+
+		if(young != live) {
+			_gc_sweep_word(page, word, young & ~live);
+		}
 	}
 
-	uintptr_t *prev = &_gc_list;
-	for(void *ptr, *next = (void *)(_gc_list & ~GC_TAG); (ptr = next); ) {
+	return;
+}
+
+static void
+_gc_sweep_young(
+	uintptr_t tag
+) {
+	size_t const old = (_gc_phase == GC_MARKING) ? (GC_OLD | GC_MARKED) : GC_OLD;
+
+	for(void *ptr, *next = (void *)_gc_young; (ptr = next); ) {
 		next = (void *)(_gc(ptr)->link & ~GC_TAG);
 
-		if(((_gc(ptr)->link ^ tag) & GC_TAG) == 0) {
-			prev = &_gc(ptr)->link;
+		if((_gc(ptr)->link ^ _gc_epoch) & GC_TAG) {
+			_gc(ptr)->link  = 0;
+			_gc(ptr)->size &= ~GC_FLAGS;
+			_gc(ptr)->sweep(_gc_wrap(ptr));
 			continue;
 		}
 
-		*prev = (uintptr_t)next | tag;
+		_gc(ptr)->link  = (_gc_list & ~GC_TAG) | tag;
+		_gc(ptr)->size |= old;
+		_gc_list        = ((uintptr_t)ptr & ~GC_TAG) | tag;
+	}
+
+	_gc_young = (uintptr_t)NULL;
+
+	struct gc_page *page = _gc_young_pages;
+	_gc_young_pages = NULL;
+	for(struct gc_page *next; page; page = next) {
+		next             = page->young_next;
+		page->young_next = NULL;
+		page->young      = false;
+		_gc_sweep_young_page(page);
+	}
+
+	_gc_young_from = _gc_stats.size_allocated;
+
+	return;
+}
+
+static inline void
+_gc_unscan(
+	void const *ptr,
+	uintptr_t   tag
+) {
+	struct gc_page *page = _gc_page_of(ptr);
+	if(page) {
+		size_t const slot = _gc_slot(page, ptr);
+		if(_gc_bit(page, GC_BITMAP_OLD, slot)) {
+			_gc_bit_clear(page, GC_BITMAP_SCANNED, slot);
+		}
+		return;
+	}
+
+	struct gc *gc = _gc_unwrap(ptr);
+	if(gc->size & GC_OLD) {
+		gc->link = (gc->link & ~GC_TAG) | tag;
+	}
+
+	return;
+}
+
+static void
+_gc_forget(
+	void
+) {
+	while(_gc_n_remembered > 0) {
+		void const     *ptr  = _gc_remembered[--_gc_n_remembered];
+		struct gc_page *page = _gc_page_of(ptr);
+		if(page) {
+			_gc_bit_clear(page, GC_BITMAP_REMEMBERED, _gc_slot(page, ptr));
+		} else {
+			_gc(_gc_unwrap(ptr))->size &= ~GC_REMEMBERED;
+		}
+	}
+
+	_gc_overflow = false;
+
+	return;
+}
 
-		_gc(ptr)->link = 0;
+// When the remembered set could not grow, every live old object is
+// treated as remembered; objects still waiting to be swept are dead
+// unless marked.
+static void
+_gc_scan_old(
+	void
+) {
+	for(void *ptr = (void *)(_gc_list & ~GC_TAG); ptr; ptr = (void *)(_gc(ptr)->link & ~GC_TAG)) {
+		_gc_scan(_gc_wrap(ptr));
+	}
+	for(void *ptr = (void *)_gc_sweeping; ptr; ptr = (void *)(_gc(ptr)->link & ~GC_TAG)) {
+		if(_gc(ptr)->size & GC_MARKED) {
+			_gc_scan(_gc_wrap(ptr));
+		}
+	}
+
+	for(size_t i = 0; i < _gc_n_pages; i++) {
+		struct gc_page *page = _gc_pages[i];
+
+		for(size_t word = 0; word < page->words; word++) {
+			size_t *const bits = _gc_bits(page, word);
+			size_t        live = bits[GC_BITMAP_LINKED] & bits[GC_BITMAP_OLD];
+			if(page->unswept) {
+				live &= bits[GC_BITMAP_MARKED];
+			}
+			for(; live; live &= live - 1) {
+				_gc_scan(_gc_slot_ptr(page, (word * GC_BITS) + GC_TZCOUNT(live)));
+			}
+		}
+	}
+
+	return;
+}
+
+static void
+_gc_unscan_old(
+	uintptr_t tag
+) {
+	for(void *ptr = (void *)(_gc_list & ~GC_TAG); ptr; ptr = (void *)(_gc(ptr)->link & ~GC_TAG)) {
+		_gc_unscan(_gc_wrap(ptr), tag);
+	}
+	for(void *ptr = (void *)_gc_sweeping; ptr; ptr = (void *)(_gc(ptr)->link & ~GC_TAG)) {
+		_gc_unscan(_gc_wrap(ptr), tag);
+	}
+
+	for(size_t i = 0; i < _gc_n_pages; i++) {
+		struct gc_page *page = _gc_pages[i];
+
+		for(size_t word = 0; word < page->words; word++) {
+			size_t *const bits = _gc_bits(page, word);
+			bits[GC_BITMAP_SCANNED] &= ~bits[GC_BITMAP_OLD];
+		}
+	}
+
+	return;
+}
+
+void
+gc_mark_and_sweep_young(
+	void
+) {
+	uintptr_t const tag = _gc_list & GC_TAG;
+
+	if((_gc_young == (uintptr_t)NULL)
+		&& !_gc_young_pages
+		&& (_gc_phase != GC_MARKING)
+	) {
+		_gc_forget();
+		_gc_young_from = _gc_stats.size_allocated;
+		return;
+	}
+
+	// Young objects are marked with the other tag, and old objects are
+	// only scanned when they are roots or have been written to.
+	_gc_epoch = tag ^ GC_TAG;
+
+	for(size_t i = _gc_stats.stack_depth; i-- > 0; ) {
+		if(_gc_phase == GC_MARKING) {
+			_gc_shade(_gc_stack[i]);
+		}
+		_gc_scan(_gc_stack[i]);
+	}
+	for(size_t i = 0; i < _gc_n_remembered; i++) {
+		_gc_scan(_gc_remembered[i]);
+	}
+	if(_gc_overflow) {
+		_gc_scan_old();
+	}
+	_gc_grey_drain(&_gc_grey_young, SIZE_MAX, _gc_mark_callback, _gc_mark);
+
+#ifdef GC_VERIFY
+	_gc_verify_marked(false);
+#endif
+
+	for(size_t i = _gc_stats.stack_depth; i-- > 0; ) {
+		_gc_unscan(_gc_stack[i], tag);
+	}
+	for(size_t i = 0; i < _gc_n_remembered; i++) {
+		_gc_unscan(_gc_remembered[i], tag);
+	}
+	if(_gc_overflow) {
+		_gc_unscan_old(tag);
+	}
+	_gc_forget();
+
+	_gc_sweep_young(tag);
+
+	_gc_stats.collections_young++;
+
+	return;
+}
+
+//------------------------------------------------------------------------------
+
+static void
+_gc_mark_begin(
+	void
+) {
+	_gc_phase = GC_MARKING;
+
+	for(size_t i = _gc_stats.stack_depth; i-- > 0; ) {
+		_gc_shade(_gc_stack[i]);
+	}
+
+	return;
+}
+
+static void
+_gc_mark_step(
+	size_t budget
+) {
+	_gc_grey_drain(&_gc_grey, budget, _gc_shade_callback, _gc_shade);
+
+	return;
+}
+
+// A last young collection promotes the survivors, and rescans the stack
+// and the objects written to since the previous one; once the shaded
+// objects are traced every live object is marked.
+static void
+_gc_mark_end(
+	void
+) {
+	gc_mark_and_sweep_young();
+	_gc_mark_step(SIZE_MAX);
+
+#ifdef GC_VERIFY
+	_gc_verify_marked(true);
+#endif
+
+	_gc_sweeping = _gc_list & ~GC_TAG;
+	_gc_list    &= GC_TAG;
+	_gc_phase    = GC_SWEEPING;
+
+	for(size_t i = 0; i < _gc_n_pages; i++) {
+		_gc_pages[i]->unswept = true;
+	}
+	_gc_sweep_next = 0;
+	_gc_sweep_end  = _gc_n_pages;
+
+	return;
+}
+
+// Old objects that were not marked are dead; pages promoted into while
+// still waiting to be swept had their survivors marked.
+static void
+_gc_sweep_page(
+	struct gc_page *page
+) {
+	for(size_t word = 0; word < page->words; word++) {
+		size_t *const bits = _gc_bits(page, word);
+		size_t  const dead = bits[GC_BITMAP_LINKED] & bits[GC_BITMAP_OLD] & ~bits[GC_BITMAP_MARKED];
+
+		bits[GC_BITMAP_MARKED] = 0;
+
+		if(dead) {
+			_gc_sweep_word(page, word, dead);
+		}
+	}
+
+	page->unswept = false;
+
+	return;
+}
+
+static bool
+_gc_sweep_step(
+	size_t budget
+) {
+	uintptr_t const tag = _gc_list & GC_TAG;
+
+	for(void *ptr; (_gc_work < budget) && (ptr = (void *)_gc_sweeping); ) {
+		_gc_sweeping  = _gc(ptr)->link & ~GC_TAG;
+		_gc_work     += _gc_size(ptr);
+
+		if(_gc(ptr)->size & GC_MARKED) {
+			_gc(ptr)->size &= ~GC_MARKED;
+			_gc(ptr)->link  = (_gc_list & ~GC_TAG) | tag;
+			_gc_list        = ((uintptr_t)ptr & ~GC_TAG) | tag;
+			continue;
+		}
+
+		_gc(ptr)->link  = 0;
+		_gc(ptr)->size &= ~GC_FLAGS;
 		_gc(ptr)->sweep(_gc_wrap(ptr));
 	}
 
+	while((_gc_work < budget) && (_gc_sweep_next < _gc_sweep_end)) {
+		struct gc_page *page = _gc_pages[_gc_sweep_next++];
+		_gc_work += (page->used << page->shift) + 1;
+		_gc_sweep_page(page);
+	}
+
+	if((_gc_sweeping != (uintptr_t)NULL)
+		|| (_gc_sweep_next < _gc_sweep_end)
+	) {
+		return false;
+	}
+
+	_gc_phase = GC_IDLE;
+
+	_gc_stats.collections_full++;
+
+	return true;
+}
+
+bool
+gc_collecting(
+	void
+) {
+	return _gc_phase != GC_IDLE;
+}
+
+// Marks or sweeps about budget bytes of the old generation, starting a
+// collection if none is in progress, and returns true once it is done.
+// Young collections may run in between steps.
+bool
+gc_mark_and_sweep_step(
+	size_t budget
+) {
+	_gc_work = 0;
+
+	if(_gc_phase == GC_IDLE) {
+		_gc_mark_begin();
+	}
+
+	if(_gc_phase == GC_MARKING) {
+		_gc_mark_step(budget);
+		if(_gc_grey.depth > 0) {
+			return false;
+		}
+
+		_gc_mark_end();
+	}
+
+	return _gc_sweep_step(budget);
+}
+
+void
+gc_mark_and_sweep(
+	void
+) {
+	if(_gc_phase == GC_SWEEPING) {
+		_gc_work = 0;
+		_gc_sweep_step(SIZE_MAX);
+	}
+
+	gc_mark_and_sweep_step(SIZE_MAX);
+
 	return;
 }
 
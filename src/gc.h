@@ -90,6 +90,20 @@ gc_pfree(
 	void const *ptr
 );
 
+struct gc_class;
+
+extern struct gc_class *
+gc_new_class(
+	size_t size,
+	void (*mark )(void const *ptr, void (*gc_mark)(void const *)),
+	void (*sweep)(void const *ptr)
+);
+
+extern void *
+gc_class_malloc(
+	struct gc_class *type
+);
+
 #define gc_sizeof(Type)  _gc_sizeof(sizeof(Type))
 extern size_t
 _gc_sizeof(
@@ -139,11 +153,36 @@ gc_unlink(
 	void const *ptr
 );
 
+extern void *
+gc_remember(
+	void const *ptr
+);
+
+extern size_t
+gc_young_size(
+	void
+);
+
 extern void
 gc_mark_and_sweep(
 	void
 );
 
+extern void
+gc_mark_and_sweep_young(
+	void
+);
+
+extern bool
+gc_collecting(
+	void
+);
+
+extern bool
+gc_mark_and_sweep_step(
+	size_t budget
+);
+
 //------------------------------------------------------------------------------
 
 struct gc_stats {
@@ -156,6 +195,8 @@ struct gc_stats {
 	size_t object_live;
 	size_t object_born;
 	size_t object_died;
+	size_t collections_young;
+	size_t collections_full;
 };
 
 extern struct gc_stats const *
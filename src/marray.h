@@ -53,7 +53,9 @@ marray_free(
 #define marray_at_capacity(Arr)                 array_at_capacity(Arr)
 #define marray_map_index(Arr,Hash,Index)        array_map_index((Arr),(Hash),(Index))
 #define marray_get_index(Arr,Hash,Cmp,Key,Len)  array_get_index((Arr),(Hash),(Cmp),(Key),(Len))
+#define marray_has_hash(Arr,Hash)              array_has_hash((Arr),(Hash))
 #define marray_foreach(Arr,Callback,Context)    array_foreach((Arr),(Callback),(Context))
+#define marray_map_clone(Arr,From)              array_map_clone((Arr),(From))
 
 //------------------------------------------------------------------------------
 
@@ -41,6 +41,7 @@ SOFTWARE.
 #include "array.h"
 #include "rand.h"
 #include "eval.h"
+#include "compile.h"
 #include "gc.h"
 
 //------------------------------------------------------------------------------
@@ -116,6 +117,7 @@ initialise(
 	initialise_system_stdio(no_alias);
 	initialise_system_ctype(no_alias);
 	initialise_system_bits(no_alias);
+	initialise_system_vector(no_alias);
 
 	if(list_builtins) {
 		marray_foreach(operators->m.env         , print_entry, operators);
@@ -181,6 +183,8 @@ main(
 		{20, "-m, --math",                      "enable math functions in the global namespace" },
 		{21, "-r, --rand GENERATOR",            "select random number GENERATOR" },
 		{22, "-A, --no-alias",                  "do not create operator aliases, use names only" },
+		{23, "-d, --depth LIMIT",               "limit evaluation depth to LIMIT (0 is unlimited, default by stack size)" },
+		{24, "-G, --gc-step SIZE",              "collect incrementally, SIZE bytes per step (0 is disabled)" },
 
 		{90, "-x, --evaluate EXPRESSION*",      "evaluates EXPRESSIONs up to -" },
 		{92, "-I, --import-path PATH",          "add search PATH for import" },
@@ -203,6 +207,8 @@ main(
 	FILE         *gfile         = NULL;
 	bool          unprocessed   = true;
 
+	limit_eval_stack(&exit_status);
+
 	for(int argi = 1; argi < argc;) {
 		char const *args = argv[argi++];
 		char const *argp = NULL;
@@ -303,6 +309,31 @@ main(
 				no_alias = true;
 				break;
 
+			case 23: {
+				char *end;
+				eval_depth_limit = (size_t)strtoull(argv[argi], &end, 0);
+				if(*end) {
+					errorf("invalid depth: %s\n", argv[argi]);
+					exit_status = EXIT_FAILURE;
+					goto end;
+				}
+				if(!eval_depth_limit) {
+					eval_stack_limit = 0;
+				}
+				break;
+			}
+
+			case 24: {
+				char *end;
+				gc_step_size = (size_t)strtoull(argv[argi], &end, 0);
+				if(*end) {
+					errorf("invalid size: %s\n", argv[argi]);
+					exit_status = EXIT_FAILURE;
+					goto end;
+				}
+				break;
+			}
+
 			case 90: {
 				unprocessed = false;
 
@@ -406,6 +437,8 @@ end:
 		printf("born objects: %zu\n", sp->object_born);
 		printf("live objects: %zu\n", sp->object_live);
 		printf("dead objects: %zu\n", sp->object_died);
+		printf("young GCs   : %zu\n", sp->collections_young);
+		printf("full GCs    : %zu\n", sp->collections_full);
 	}
 
 	return exit_status;
@@ -502,6 +535,8 @@ process(
 			graph(gfile, gtitle, ast);
 		}
 		if(ast && doeval) {
+			ast = fold(env, ast);
+			compile(ast);
 			ast = refeval(env, ast);
 			if(!quiet) {
 				print(ast);
@@ -24,6 +24,7 @@ SOFTWARE.
 #include "parse.h"
 #include "lex.h"
 #include "env.h"
+#include "eval.h"
 #include "hash.h"
 #include "utf8.h"
 #include <stdbool.h>
@@ -192,6 +193,35 @@ parse_assemblage(
 	)
 );
 
+// Once the native stack runs short, the rest of a bracketed group is
+// skipped and stands for a DepthExceeded error.
+static Ast
+parse_too_deep(
+	ParseState ps,
+	sloc_t     sloc
+) {
+	for(size_t depth = 1; depth > 0;) {
+		char const *leme = parse_peek(ps);
+
+		switch(*leme) {
+		case '(': case '[': case '{':
+			depth += (ps->len == 1);
+			break;
+		case ')': case ']': case '}':
+			depth--;
+			break;
+		case '\0':
+			return oboerr(sloc, ERR_DepthExceeded);
+		default:
+			break;
+		}
+
+		parse_accept(ps);
+	}
+
+	return oboerr(sloc, ERR_DepthExceeded);
+}
+
 static Ast
 parse_primary(
 	ParseState ps,
@@ -218,6 +248,9 @@ parse_primary(
 			break;
 		}
 		parse_accept(ps);
+		if(stack_exhausted(stack_limit)) {
+			return parse_too_deep(ps, sloc);
+		}
 		if(!parse_peek_closing(ps, ')')) {
 			expr = parse_assemblage(ps, ast);
 			if(parse_peek_closing(ps, ')')) {
@@ -240,6 +273,9 @@ parse_primary(
 			break;
 		}
 		parse_accept(ps);
+		if(stack_exhausted(stack_limit)) {
+			return parse_too_deep(ps, sloc);
+		}
 		if(!parse_peek_closing(ps, ']')) {
 			expr = parse_assemblage(ps, ast);
 		}
@@ -258,6 +294,9 @@ parse_primary(
 			break;
 		}
 		parse_accept(ps);
+		if(stack_exhausted(stack_limit)) {
+			return parse_too_deep(ps, sloc);
+		}
 		if(!parse_peek_closing(ps, '}')) {
 			expr = parse_assemblage(ps, ast);
 		}
@@ -381,7 +420,7 @@ parse_sequence(
 
 	for(Ast last = expr, *lastp = &expr;
 		parse_peek_sequence(ps);
-		*lastp = last, lastp = &last->m.rexpr
+		*lastp = gc_remember(last), lastp = &last->m.rexpr
 	) {
 		size_t      len;
 		sloc_t      sloc  = parse_sloc(ps);
@@ -408,7 +447,7 @@ parse_assemblage(
 
 	for(Ast last = expr, *lastp = &expr;
 		parse_peek_assemblage(ps);
-		*lastp = last, lastp = &last->m.rexpr
+		*lastp = gc_remember(last), lastp = &last->m.rexpr
 	) {
 		size_t      len;
 		sloc_t      sloc  = parse_sloc(ps);
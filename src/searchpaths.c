@@ -83,9 +83,9 @@ add_searchpath(
 	}
 
 	Ast    ast   = new_ast(sloc, AST_String, s);
-	size_t index = locate(searchpaths, ast->m.hash, cs, n);
+	size_t index = locate(searchpaths, ast_hash(ast), cs, n);
 	if(!~index) {
-		index = define(searchpaths, ast->m.hash, ast, ATTR_NoAssign);
+		index = define(searchpaths, ast_hash(ast), ast, ATTR_NoAssign);
 		assert(~index != 0);
 	}
 
@@ -67,9 +67,9 @@ add_source(
 	size_t      n;
 	char const *cs    = StringToCharLiteral(s, &n);
 	Ast         ast   = new_ast(sloc, AST_String, s);
-	size_t      index = locate(sources, ast->m.hash, cs, n);
+	size_t      index = locate(sources, ast_hash(ast), cs, n);
 	if(!~index) {
-		index = define(sources, ast->m.hash, ast, ATTR_NoAssign);
+		index = define(sources, ast_hash(ast), ast, ATTR_NoAssign);
 		assert(~index != 0 && (index < ULONG_MAX));
 	}
 
@@ -24,6 +24,8 @@ SOFTWARE.
 #include "string.h"
 #include "bits.h"
 #include "gc.h"
+#include "assert.h"
+#include "utf8.h"
 
 //------------------------------------------------------------------------------
 
@@ -38,6 +40,37 @@ struct string {
 #define SSO_SIZE (sizeof(struct string) - 1)
 #define SSO_MASK (((size_t)1 << (CHAR_BIT - 1)) - 1)
 
+// Code point queries on a string are answered from an index built on first
+// use: ASCII strings map code points to bytes directly, otherwise the byte
+// offset of every CODEPOINT_STEP'th code point is recorded.  Any change to
+// the string discards its index.
+struct codepoints {
+	size_t length;
+	size_t n;
+	size_t offset[];
+};
+
+#define CODEPOINT_STEP 64
+
+struct handle {
+	struct string      s;
+	struct codepoints *codepoints;
+};
+
+// Concatenations at least ROPE_MIN long are deferred: the result records its
+// two pieces and is only flattened when its characters are first needed, or
+// once it is built from more than ROPE_LIMIT concatenations.
+struct rope {
+	struct handle h;
+	StringConst   left;
+	StringConst   right;
+	size_t        count;
+};
+
+#define ROPE_CAP   SIZE_MAX
+#define ROPE_MIN   (STRING_MIN * 8)
+#define ROPE_LIMIT 1024
+
 //------------------------------------------------------------------------------
 
 static inline bool
@@ -97,10 +130,25 @@ string_len(
 	return s->len >> is_little_endian();
 }
 
+static inline bool
+is_rope_string(
+	StringConst s
+) {
+	return !is_sso_string(s) && (s->cap == ROPE_CAP);
+}
+
+static char *
+flatten_rope(
+	StringConst s
+);
+
 static inline size_t
 string_cap(
 	StringConst s
 ) {
+	if(s->cap == ROPE_CAP) {
+		flatten_rope(s);
+	}
 	return s->cap;
 }
 
@@ -108,7 +156,7 @@ static inline char *
 string_ptr(
 	StringConst s
 ) {
-	return s->ptr;
+	return (s->cap == ROPE_CAP) ? flatten_rope(s) : s->ptr;
 }
 
 static inline size_t
@@ -137,9 +185,21 @@ unpack_string(
 	StringConst s,
 	String      t
 ) {
+	t->ptr = string_pointer(s);
 	t->len = string_length(s);
 	t->cap = string_capacity(s);
-	t->ptr = string_pointer(s);
+}
+
+static inline void
+drop_codepoints(
+	StringConst s
+) {
+	struct handle *h = (struct handle *)s;
+
+	if(h->codepoints) {
+		free(h->codepoints);
+		h->codepoints = NULL;
+	}
 }
 
 static inline String
@@ -147,6 +207,8 @@ pack_string(
 	String      s,
 	StringConst t
 ) {
+	drop_codepoints(s);
+
 	if(t->len >= SSO_SIZE) {
 		s->len = t->len << is_little_endian();
 		s->cap = t->cap;
@@ -252,6 +314,140 @@ expand_unpacked_string(
 	return true;
 }
 
+static char *
+copy_rope(
+	char        *p,
+	StringConst  s
+) {
+	StringConst  local[32];
+	StringConst *stack = local;
+	size_t       depth = 0;
+	size_t       limit = sizeof(local) / sizeof(local[0]);
+
+	for(stack[depth++] = s; depth > 0; ) {
+		s = stack[--depth];
+
+		if(is_rope_string(s)) {
+			struct rope const *r = (struct rope const *)s;
+
+			if((limit - depth) < 2) {
+				StringConst *grow = malloc(2 * limit * sizeof(*grow));
+				assert(grow != NULL);
+				memcpy(grow, stack, depth * sizeof(*grow));
+				if(stack != local) {
+					free(stack);
+				}
+				stack  = grow;
+				limit *= 2;
+			}
+
+			stack[depth++] = r->right;
+			stack[depth++] = r->left;
+
+		} else {
+			size_t n = string_length(s);
+			memcpy(p, string_pointer(s), n);
+			p += n;
+		}
+	}
+
+	if(stack != local) {
+		free(stack);
+	}
+
+	return p;
+}
+
+static char *
+flatten_rope(
+	StringConst s
+) {
+	struct rope *r = (struct rope *)s;
+	size_t const n = string_len(s);
+	size_t const z = string_allocation_size(n);
+
+	char *p = malloc(z);
+	assert(p != NULL);
+	*copy_rope(p, s) = '\0';
+
+	r->h.s.cap = z - 1;
+	r->h.s.ptr = p;
+	r->left  = NULL;
+	r->right = NULL;
+
+	return p;
+}
+
+static void
+mark_rope(
+	void const *p,
+	void      (*gc_mark)(void const *)
+) {
+	struct rope const *r = p;
+
+	if(r->h.s.cap == ROPE_CAP) {
+		gc_mark(r->left);
+		gc_mark(r->right);
+	}
+}
+
+static void
+sweep_rope(
+	void const *p
+) {
+	struct rope *r = (struct rope *)p;
+
+	if(r->h.s.cap != ROPE_CAP) {
+		free(r->h.s.ptr);
+	}
+	free(r->h.codepoints);
+	free(r);
+}
+
+static inline size_t
+rope_count(
+	StringConst s
+) {
+	return is_rope_string(s) ? ((struct rope const *)s)->count : 0;
+}
+
+static String
+make_rope(
+	StringConst left,
+	StringConst right
+) {
+	size_t const n = string_length(left) + string_length(right);
+	if(n >= STRING_MAX) {
+		return NULL;
+	}
+
+	struct rope *r = gc_malloc(sizeof(*r), mark_rope, sweep_rope);
+	if(r) {
+		r->h.codepoints = NULL;
+		struct string const t = { n, ROPE_CAP, NULL };
+		pack_string(&r->h.s, &t);
+		r->left  = gc_push(left);
+		r->right = gc_push(right);
+		r->count = 1 + rope_count(left) + rope_count(right);
+		if(r->count > ROPE_LIMIT) {
+			flatten_rope(&r->h.s);
+		}
+		return &r->h.s;
+	}
+
+	return NULL;
+}
+
+static void
+sweep_string(
+	void const *p
+) {
+	struct handle *h = (struct handle *)p;
+
+	free(h->codepoints);
+	free(h);
+}
+
 static String
 make_string(
 	size_t reserve,
@@ -265,9 +461,10 @@ make_string(
 		if(p) {
 
 			struct string const t = { length, reserve - !reserve, p };
-			String              s = malloc(sizeof(*s));
-			if(s) {
-				return pack_string(s, &t);
+			struct handle      *h = gc_malloc(sizeof(*h), NULL, sweep_string);
+			if(h) {
+				h->codepoints = NULL;
+				return pack_string(&h->s, &t);
 			}
 		}
 	}
@@ -357,9 +554,10 @@ StringDelete(
 	StringConst s
 ) {
 	if(s) {
-		if(!is_sso_string(s)) {
+		if(!is_sso_string(s) && !is_rope_string(s)) {
 			free(s->ptr);
 		}
+		drop_codepoints(s);
 		free(s);
 	}
 }
@@ -536,6 +734,20 @@ StringAppend(
 	String      t,
 	StringConst s
 ) {
+	if(t && s && is_rope_string(s)) {
+		struct string u;
+		unpack_string(t, &u);
+
+		if(expand_unpacked_string(&u, string_len(s))) {
+			u.len        = (size_t)(copy_rope(u.ptr + u.len, s) - u.ptr);
+			u.ptr[u.len] = '\0';
+
+			return pack_string(t, &u);
+		}
+
+		return t;
+	}
+
 	return StringAppendCharLiteral(t, char_pointer(s), StringLength(s));
 }
 
@@ -544,6 +756,14 @@ StringConcatenate(
 	StringConst s1,
 	StringConst s2
 ) {
+	if(s1 && s2
+		&& (StringLength(s1) > 0)
+		&& (StringLength(s2) > 0)
+		&& ((StringLength(s1) + StringLength(s2)) >= ROPE_MIN)
+	) {
+		return make_rope(s1, s2);
+	}
+
 	return CharLiteralsToString(
 		char_pointer(s1), StringLength(s1),
 		char_pointer(s2), StringLength(s2)
@@ -595,6 +815,104 @@ StringToCharLiteral(
 	return char_pointer(s);
 }
 
+static inline size_t
+codepoint_step(
+	char const *cs,
+	size_t      off,
+	size_t      n
+) {
+	size_t const step = utf8off(cs + off, NULL, CODEPOINT_STEP);
+	return (step < (n - off)) ? step : (n - off);
+}
+
+static struct codepoints const *
+codepoints_of(
+	StringConst s
+) {
+	struct handle *h = (struct handle *)s;
+	if(h->codepoints) {
+		return h->codepoints;
+	}
+
+	size_t      n  = string_length(s);
+	char const *cs = string_pointer(s);
+
+	size_t i = 0;
+	while((i < n) && ((unsigned char)(cs[i] - 1) < 0x7F)) {
+		++i;
+	}
+
+	size_t m = 0;
+	if(i < n) {
+		for(size_t off = 0, step; (off < n) && (step = codepoint_step(cs, off, n)); off += step) {
+			++m;
+		}
+		++m;
+	}
+
+	struct codepoints *c = malloc(sizeof(*c) + (m * sizeof(c->offset[0])));
+	if(c) {
+		c->length = (i < n) ? utf8len(cs, NULL, n) : n;
+		c->n      = m;
+		for(size_t k = 0; k < m; k++) {
+			c->offset[k] = k ? (c->offset[k-1] + codepoint_step(cs, c->offset[k-1], n)) : 0;
+		}
+		h->codepoints = c;
+	}
+
+	return c;
+}
+
+size_t
+StringCodePoints(
+	StringConst s
+) {
+	if(!s) {
+		return 0;
+	}
+
+	if(!is_sso_string(s)) {
+		struct codepoints const *c = codepoints_of(s);
+		if(c) {
+			return c->length;
+		}
+	}
+
+	return utf8len(char_pointer(s), NULL, StringLength(s));
+}
+
+size_t
+StringCodePointOffset(
+	StringConst s,
+	size_t      index
+) {
+	if(!s) {
+		return 0;
+	}
+
+	if(!is_sso_string(s)) {
+		struct codepoints const *c = codepoints_of(s);
+		if(c) {
+			if(c->n == 0) {
+				size_t const n = string_len(s);
+				return (index < n) ? index : n;
+			}
+
+			size_t k = index / CODEPOINT_STEP;
+			if(k >= c->n) {
+				k = c->n - 1;
+			}
+
+			size_t const off = c->offset[k];
+			size_t const n   = string_len(s);
+			size_t const r   = off + utf8off(string_pointer(s) + off, NULL, index - (k * CODEPOINT_STEP));
+			return (r < n) ? r : n;
+		}
+	}
+
+	return utf8off(char_pointer(s), NULL, index);
+}
+
 int
 StringEqualCharLiteral(
 	StringConst s,
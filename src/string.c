@@ -24,6 +24,7 @@ SOFTWARE.
 #include "string.h"
 #include "bits.h"
 #include "gc.h"
+#include "utf8.h"
 
 //------------------------------------------------------------------------------
 
@@ -467,6 +468,21 @@ StringToCharLiteral(
 	return char_pointer(s);
 }
 
+size_t
+StringCodePoints(
+	StringConst s
+) {
+	return utf8len(char_pointer(s), NULL, StringLength(s));
+}
+
+size_t
+StringCodePointOffset(
+	StringConst s,
+	size_t      index
+) {
+	return utf8off(char_pointer(s), NULL, index);
+}
+
 int
 StringEqualCharLiteral(
 	StringConst s,
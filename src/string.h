@@ -174,6 +174,17 @@ StringToCharLiteral(
 	size_t     *n
 );
 
+extern size_t
+StringCodePoints(
+	StringConst s
+);
+
+extern size_t
+StringCodePointOffset(
+	StringConst s,
+	size_t      index
+);
+
 extern int
 StringEqualCharLiteral(
 	StringConst s,
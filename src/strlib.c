@@ -268,22 +268,20 @@ HashString(
 
 size_t
 codepointoffset(
-	char   const *cs,
-	size_t const  n,
-	size_t        r
+	StringConst s,
+	size_t      r
 ) {
-	size_t const m = utf8len(cs, NULL, n);
-	return ~m ? utf8off(cs, NULL, (r < m) ? r : m) : 0;
+	size_t const m = StringCodePoints(s);
+	return ~m ? StringCodePointOffset(s, (r < m) ? r : m) : 0;
 }
 
 size_t
 reversecodepointoffset(
-	char   const *cs,
-	size_t const  n,
-	size_t        r
+	StringConst s,
+	size_t      r
 ) {
-	size_t const m = utf8len(cs, NULL, n);
-	return ~m ? utf8off(cs, NULL, (r < m) ? (m - r) : 0) : 0;
+	size_t const m = StringCodePoints(s);
+	return ~m ? StringCodePointOffset(s, (r < m) ? (m - r) : 0) : 0;
 }
 
 //------------------------------------------------------------------------------
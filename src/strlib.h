@@ -106,16 +106,14 @@ HashString(
 
 extern size_t
 codepointoffset(
-	char   const *cs,
-	size_t const  n,
-	size_t        r
+	StringConst s,
+	size_t      r
 );
 
 extern size_t
 reversecodepointoffset(
-	char   const *cs,
-	size_t const  n,
-	size_t        r
+	StringConst s,
+	size_t      r
 );
 
 //------------------------------------------------------------------------------
@@ -33,10 +33,12 @@ SOFTWARE.
 #include "rand.h"
 #include "hash.h"
 #include "eval.h"
+#include "compile.h"
 #include "env.h"
 #include "gc.h"
 #include "utf8.h"
 #include <stdlib.h>
+#include <math.h>
 #include <locale.h>
 #include <stdio.h>
 #include <uchar.h>
@@ -91,6 +93,18 @@ static unsigned builtin_parse_enum         = -1u;
 static unsigned builtin_load_enum          = -1u;
 static unsigned builtin_import_enum        = -1u;
 static unsigned builtin_exit_enum          = -1u;
+static unsigned builtin_sum_enum           = -1u;
+static unsigned builtin_product_enum       = -1u;
+static unsigned builtin_min_enum           = -1u;
+static unsigned builtin_max_enum           = -1u;
+static unsigned builtin_dot_enum           = -1u;
+static unsigned builtin_map_enum           = -1u;
+static unsigned builtin_filter_enum        = -1u;
+static unsigned builtin_fold_enum          = -1u;
+static unsigned builtin_sort_enum          = -1u;
+static unsigned builtin_nth_enum           = -1u;
+static unsigned builtin_top_enum           = -1u;
+static unsigned builtin_lower_bound_enum   = -1u;
 
 //------------------------------------------------------------------------------
 
@@ -256,7 +270,7 @@ builtin_system(
 
 		do {
 			Ast  ast      = builtin_system_1(env, sloc, ast_isSequence(arg) ? arg->m.lexpr : arg);
-			bool appended = marray_push_back(vec->m.env, Ast, ast);
+			bool appended = marray_push_back(vec->m.env, Ast, gc_remember(ast));
 			assert(appended);
 
 		} while(ast_isSequence(arg) && (arg = arg->m.rexpr))
@@ -340,15 +354,11 @@ builtin_length(
 	arg = eval(env, arg);
 	size_t len = 0;
 	switch(ast_type(arg)) {
-	case AST_String: case AST_Identifier: {
-			char const *cs = StringToCharLiteral(arg->m.sval, &len);
-			len = utf8len(cs, &cs, len);
-		}
+	case AST_String: case AST_Identifier:
+		len = StringCodePoints(arg->m.sval);
 		break;
 	case AST_Sequence:
-		for(len = 1; ast_isSequence(arg); arg = arg->m.rexpr) {
-			++len;
-		}
+		len = sequence_length(arg);
 		break;
 	case AST_Assemblage:
 		for(len = 1; ast_isAssemblage(arg); arg = arg->m.rexpr) {
@@ -359,6 +369,9 @@ builtin_length(
 		len = marray_length(arg->m.env);
 		break;
 	default:
+		if(ast_isVector(arg)) {
+			len = vector_length(arg);
+		}
 		break;
 	}
 	return new_ast(sloc, AST_Integer, len);
@@ -930,6 +943,7 @@ builtin_parse(
 			unsigned long line   = sloc_line(sloc);
 
 			arg = parse(args, &args, source, &line, new_ast_from_lexeme, true);
+			compile(arg);
 
 			return new_ast(sloc, AST_Quoted, arg);
 		}
@@ -979,6 +993,8 @@ import(
 		) {
 			arg = parse(cs, &cs, source, &line, new_ast_from_lexeme, false);
 			if(ast_isnotZen(arg)) {
+				arg = fold(env, arg);
+				compile(arg);
 				arg = eval(env, arg);
 			}
 
@@ -1056,6 +1072,909 @@ builtin_exit(
 
 //------------------------------------------------------------------------------
 
+static Ast
+reduce_range(
+	sloc_t sloc,
+	Ast    range,
+	Reduce op
+) {
+	if(ast_isZen(range->m.rexpr)) {
+		return oboerr(sloc, ERR_InvalidOperand);
+	}
+
+	uint64_t lo = ast_toInteger(range->m.lexpr);
+	uint64_t hi = ast_toInteger(range->m.rexpr);
+	if(lo > hi) {
+		uint64_t temp = lo;
+		lo            = hi;
+		hi            = temp;
+	}
+
+	uint64_t acc;
+	switch(op) {
+	case REDUCE_sum: {
+			uint64_t const n = hi - lo + 1;
+			acc = (n & 1) ? (
+				n * ((lo >> 1) + (hi >> 1) + (lo & 1))
+			) : (
+				(n >> 1) * (lo + hi)
+			);
+		}
+		break;
+	case REDUCE_product:
+		for(acc = lo; (lo != hi) && (acc != 0); ) {
+			acc *= ++lo;
+		}
+		break;
+	case REDUCE_min:
+		acc = lo;
+		break;
+	case REDUCE_max:
+		acc = hi;
+		break;
+	default:
+		return oboerr(sloc, ERR_InvalidOperand);
+	}
+
+	return new_ast(sloc, AST_Integer, acc);
+}
+
+static Ast
+reduce_operator(
+	sloc_t      sloc,
+	char const *name
+) {
+	Ast op = deref(named_inenv(operators, sloc, name));
+	return ast_isBuiltinOperator(op) ? op : NULL;
+}
+
+static Ast
+reduce_array(
+	Ast    env,
+	sloc_t sloc,
+	Ast    arr,
+	Reduce op
+) {
+	size_t const n = marray_length(arr->m.env);
+
+	Ast acc;
+	switch(op) {
+	case REDUCE_sum:
+		acc = new_ast(sloc, AST_Integer, UINT64_C(0));
+		break;
+	case REDUCE_product:
+		acc = new_ast(sloc, AST_Integer, UINT64_C(1));
+		break;
+	default:
+		if(n == 0) {
+			return ZEN;
+		}
+		acc = deref(env_element(arr->m.env, 0));
+		break;
+	}
+
+	Ast oper = reduce_operator(sloc,
+		(op == REDUCE_sum) ? "`add`" :
+		(op == REDUCE_product) ? "`mul`" :
+		(op == REDUCE_min) ? "`lt`" : "`gt`"
+	);
+	if(!oper) {
+		return oboerr(sloc, ERR_InvalidOperator);
+	}
+
+	size_t ts = gc_topof_stack();
+	gc_push(acc);
+
+	for(size_t i = (op >= REDUCE_min); i < n; ++i) {
+		Ast value = deref(env_element(arr->m.env, i));
+		if((op == REDUCE_sum) || (op == REDUCE_product)) {
+			acc = oper->m.bop(env, sloc, acc, value);
+			if(ast_isError(acc)) {
+				break;
+			}
+		} else {
+			Ast is = oper->m.bop(env, sloc, value, acc);
+			if(ast_isError(is)) {
+				acc = is;
+				break;
+			}
+			if(ast_toBool(is)) {
+				acc = value;
+			}
+		}
+		gc_return(ts, acc);
+	}
+
+	return gc_return(ts, acc);
+}
+
+static Ast
+builtin_reduce(
+	Ast    env,
+	sloc_t sloc,
+	Ast    arg,
+	Reduce op
+) {
+	arg = eval(env, arg);
+
+	if(ast_isRange(arg)) {
+		return reduce_range(sloc, arg, op);
+	}
+
+	if(ast_isVector(arg)) {
+		return vector_reduce(sloc, arg, op);
+	}
+
+	if(ast_isEnvironment(arg)) {
+		size_t ts = gc_topof_stack();
+		gc_push(arg);
+
+		Ast vec = pack_vector(sloc, arg, true);
+		if(vec) {
+			gc_push(vec);
+			return gc_return(ts, vector_reduce(sloc, vec, op));
+		}
+
+		return gc_return(ts, reduce_array(env, sloc, arg, op));
+	}
+
+	return error_or(sloc, arg, ERR_InvalidOperand);
+}
+#define BUILTIN_REDUCE(Name) \
+static Ast \
+builtin_##Name( \
+	Ast    env,  \
+	sloc_t sloc, \
+	Ast    arg   \
+) { \
+	return builtin_reduce(env, sloc, arg, REDUCE_##Name); \
+}
+
+BUILTIN_REDUCE(sum)
+BUILTIN_REDUCE(product)
+BUILTIN_REDUCE(min)
+BUILTIN_REDUCE(max)
+
+static Ast
+dot_array(
+	Ast    env,
+	sloc_t sloc,
+	Ast    lexpr,
+	Ast    rexpr
+) {
+	Ast add = reduce_operator(sloc, "`add`");
+	Ast mul = reduce_operator(sloc, "`mul`");
+	if(!add || !mul) {
+		return oboerr(sloc, ERR_InvalidOperator);
+	}
+
+	size_t const ln = marray_length(lexpr->m.env);
+	size_t const rn = marray_length(rexpr->m.env);
+	size_t const n  = (ln < rn) ? ln : rn;
+
+	Ast acc = new_ast(sloc, AST_Integer, UINT64_C(0));
+
+	size_t ts = gc_topof_stack();
+	gc_push(acc);
+
+	for(size_t i = 0; i < n; ++i) {
+		Ast lval = deref(env_element(lexpr->m.env, i));
+		Ast rval = deref(env_element(rexpr->m.env, i));
+		Ast prod = mul->m.bop(env, sloc, lval, rval);
+		if(ast_isError(prod)) {
+			acc = prod;
+			break;
+		}
+		gc_push(prod);
+		acc = add->m.bop(env, sloc, acc, prod);
+		if(ast_isError(acc)) {
+			break;
+		}
+		gc_return(ts, acc);
+	}
+
+	return gc_return(ts, acc);
+}
+
+static Ast
+builtin_dot(
+	Ast    env,
+	sloc_t sloc,
+	Ast    arg
+) {
+	if(ast_isSequence(arg)) {
+		size_t ts = gc_topof_stack();
+
+		Ast lexpr = gc_push(eval(env, arg->m.lexpr));
+		Ast rexpr = gc_push(eval(env, arg->m.rexpr));
+		Ast lvec  = ast_isEnvironment(lexpr) ? pack_vector(sloc, lexpr, true) : lexpr;
+		Ast rvec  = ast_isEnvironment(rexpr) ? pack_vector(sloc, rexpr, true) : rexpr;
+
+		if(lvec && rvec && ast_isVector(lvec) && ast_isVector(rvec)) {
+			gc_push(lvec);
+			gc_push(rvec);
+			return gc_return(ts, vector_dot(sloc, lvec, rvec));
+		}
+
+		if(ast_isEnvironment(lexpr) && ast_isEnvironment(rexpr)) {
+			return gc_return(ts, dot_array(env, sloc, lexpr, rexpr));
+		}
+
+		gc_revert(ts);
+		return error_or(sloc, ast_isError(lexpr) ? lexpr : rexpr, ERR_InvalidOperand);
+	}
+
+	return error_or(sloc, arg, ERR_InvalidOperand);
+}
+
+//------------------------------------------------------------------------------
+
+static inline Ast
+apply_function(
+	Ast    env,
+	sloc_t sloc,
+	Ast    function,
+	Ast    args,
+	Ast   *spare
+) {
+	return ast_isBuiltinFunction(function) ? (
+		function->m.bfn(env, sloc, args)
+	) : (
+		apply(env, sloc, function, args, spare)
+	);
+}
+
+static inline bool
+ast_isApplicable(
+	Ast ast
+) {
+	return ast_isFunction(ast) || ast_isBuiltinFunction(ast);
+}
+
+struct elements {
+	Ast      arr;
+	uint64_t first;
+	uint64_t step;
+	size_t   length;
+};
+
+static bool
+elements_of(
+	struct elements *e,
+	Ast              ast
+) {
+	if(ast_isEnvironment(ast)) {
+		e->arr    = ast;
+		e->length = marray_length(ast->m.env);
+		return true;
+	}
+
+	if(ast_isRange(ast) && ast_isnotZen(ast->m.rexpr)) {
+		uint64_t const last = ast_toInteger(ast->m.rexpr);
+		e->arr    = NULL;
+		e->first  = ast_toInteger(ast->m.lexpr);
+		e->step   = (e->first > last) ? UINT64_C(-1) : 1;
+		e->length = ((e->first > last) ? (e->first - last) : (last - e->first)) + 1;
+		return true;
+	}
+
+	return false;
+}
+
+static bool
+binds_by_reference(
+	Ast idents
+) {
+	for(; ast_isSequence(idents); idents = idents->m.rexpr) {
+		if(!ast_isTag(idents->m.lexpr)) {
+			return true;
+		}
+	}
+
+	return ast_isnotZen(idents) && !ast_isTag(idents);
+}
+
+// Elements are bound to by-reference parameters as they are, so a shared
+// array is unshared first when applying function could write through one.
+static void
+elements_for(
+	struct elements const *e,
+	Ast                    function
+) {
+	if(e->arr
+		&& (ast_isBuiltinFunction(function)
+			|| (binds_by_reference(function->m.lexpr) && !reads_only(function->m.rexpr))
+		)
+	) {
+		unshare_env(e->arr->m.env);
+	}
+}
+
+static inline size_t
+elements_length(
+	struct elements const *e
+) {
+	return e->arr ? marray_length(e->arr->m.env) : e->length;
+}
+
+static inline Ast
+element_at(
+	struct elements const *e,
+	sloc_t                 sloc,
+	size_t                 index
+) {
+	if(e->arr) {
+		return deref(env_element(e->arr->m.env, index));
+	}
+
+	return new_ast(sloc, AST_Integer, e->first + (index * e->step));
+}
+
+static Ast
+builtin_map_or_filter(
+	Ast    env,
+	sloc_t sloc,
+	Ast    arg,
+	bool   filter
+) {
+	if(ast_isSequence(arg)) {
+		size_t ts = gc_topof_stack();
+
+		Ast arr      = gc_push(eval(env, arg->m.lexpr));
+		Ast function = gc_push(eval(env, arg->m.rexpr));
+
+		struct elements e;
+		if(elements_of(&e, arr) && ast_isApplicable(function)) {
+			elements_for(&e, function);
+
+			size_t const n   = elements_length(&e);
+			Ast          out = gc_push(new_env(sloc, NULL));
+			if(!filter && (n > 0)) {
+				bool expanded = marray_expand(out->m.env, sizeof(Ast), n);
+				assert(expanded);
+			}
+
+			size_t const ti    = gc_topof_stack();
+			Ast          spare = NULL;
+
+			for(size_t i = 0; i < elements_length(&e); ++i) {
+				Ast value  = element_at(&e, sloc, i);
+				Ast result = apply_function(env, sloc, function, value, &spare);
+				if(ast_isError(result)) {
+					return gc_return(ts, result);
+				}
+				if(!filter) {
+					bool appended = marray_push_back(out->m.env, Ast, gc_remember(dup_ast(sloc, result)));
+					assert(appended);
+				} else if(ast_toBool(result)) {
+					bool appended = marray_push_back(out->m.env, Ast, gc_remember(dup_ast(sloc, value)));
+					assert(appended);
+				}
+
+				gc_revert(ti);
+				if(spare) {
+					gc_push(spare);
+				}
+			}
+
+			return gc_return(ts, out);
+		}
+
+		gc_revert(ts);
+		return error_or(sloc, ast_isError(arr) ? arr : function, ERR_InvalidOperand);
+	}
+
+	return error_or(sloc, arg, ERR_InvalidOperand);
+}
+
+static Ast
+builtin_map(
+	Ast    env,
+	sloc_t sloc,
+	Ast    arg
+) {
+	return builtin_map_or_filter(env, sloc, arg, false);
+}
+
+static Ast
+builtin_filter(
+	Ast    env,
+	sloc_t sloc,
+	Ast    arg
+) {
+	return builtin_map_or_filter(env, sloc, arg, true);
+}
+
+static Ast
+builtin_fold(
+	Ast    env,
+	sloc_t sloc,
+	Ast    arg
+) {
+	if(ast_isSequence(arg)) {
+		size_t ts = gc_topof_stack();
+
+		Ast arr      = gc_push(eval(env, arg->m.lexpr));
+		Ast function = arg->m.rexpr;
+		Ast acc      = NULL;
+		if(ast_isSequence(function)) {
+			acc      = gc_push(eval(env, function->m.rexpr));
+			function = function->m.lexpr;
+		}
+		function = gc_push(eval(env, function));
+
+		struct elements e;
+		if(elements_of(&e, arr) && ast_isApplicable(function)) {
+			elements_for(&e, function);
+
+			size_t i = 0;
+			if(!acc) {
+				if(elements_length(&e) == 0) {
+					gc_revert(ts);
+					return ZEN;
+				}
+				acc = element_at(&e, sloc, i++);
+			}
+
+			Ast args  = gc_push(new_ast(sloc, AST_Sequence, acc, ZEN));
+			Ast spare = NULL;
+
+			size_t const ti = gc_topof_stack();
+
+			for(; i < elements_length(&e); ++i) {
+				args->m.lexpr = acc;
+				args->m.rexpr = element_at(&e, sloc, i);
+				acc = apply_function(env, sloc, function, args, &spare);
+				if(ast_isError(acc)) {
+					break;
+				}
+
+				gc_revert(ti);
+				gc_push(acc);
+				if(spare) {
+					gc_push(spare);
+				}
+			}
+
+			return gc_return(ts, acc);
+		}
+
+		gc_revert(ts);
+		return error_or(sloc, ast_isError(arr) ? arr : function, ERR_InvalidOperand);
+	}
+
+	return error_or(sloc, arg, ERR_InvalidOperand);
+}
+
+//------------------------------------------------------------------------------
+
+typedef enum {
+	ORDER_Any,
+	ORDER_Integer,
+	ORDER_Float,
+	ORDER_String
+} OrderKind;
+
+struct order {
+	Ast       env;
+	sloc_t    sloc;
+	Ast       function;
+	Ast       args;
+	Ast       spare;
+	Ast       error;
+	size_t    ts;
+	OrderKind kind;
+};
+
+struct item {
+	Ast    ast;
+	size_t index;
+	union {
+		uint64_t u;
+		double   f;
+	}      key;
+};
+
+static void
+order_begin(
+	struct order *o,
+	Ast           env,
+	sloc_t        sloc,
+	Ast           function
+) {
+	o->env      = env;
+	o->sloc     = sloc;
+	o->function = function;
+	o->args     = function ? gc_push(new_ast(sloc, AST_Sequence, ZEN, ZEN)) : NULL;
+	o->spare    = NULL;
+	o->error    = NULL;
+	o->ts       = gc_topof_stack();
+	o->kind     = ORDER_Any;
+}
+
+static bool
+order_less(
+	struct order      *o,
+	struct item const *l,
+	struct item const *r
+) {
+	switch(o->kind) {
+	case ORDER_Integer:
+		return l->key.u < r->key.u;
+	case ORDER_Float:
+		return !isunordered(l->key.f, r->key.f) && isless(l->key.f, r->key.f);
+	case ORDER_String:
+		return StringCompare(l->ast->m.sval, r->ast->m.sval) < 0;
+	default:
+		break;
+	}
+
+	if(o->error) {
+		return false;
+	}
+
+	bool less;
+	if(o->function) {
+		o->args->m.lexpr = l->ast;
+		o->args->m.rexpr = r->ast;
+		Ast ast = apply_function(o->env, o->sloc, o->function, o->args, &o->spare);
+		if(ast_isError(ast)) {
+			o->error = ast;
+		}
+		less = ast_toBool(ast);
+	} else {
+		int const lt = compare_less(o->env, o->sloc, l->ast, r->ast);
+		if(lt < 0) {
+			o->error = oboerr(o->sloc, ERR_InvalidOperand);
+		}
+		less = (lt > 0);
+	}
+
+	gc_revert(o->ts);
+	if(o->error) {
+		gc_push(o->error);
+	}
+	if(o->spare) {
+		gc_push(o->spare);
+	}
+
+	return less;
+}
+
+static inline bool
+order_before(
+	struct order      *o,
+	struct item const *l,
+	struct item const *r
+) {
+	return order_less(o, l, r) || (!order_less(o, r, l) && (l->index < r->index));
+}
+
+// Collects the elements of arr, choosing a key comparison when they are
+// all numbers of one kind or all strings and no comparator is given.
+static struct item *
+order_items(
+	struct order *o,
+	Ast           arr
+) {
+	size_t const n     = marray_length(arr->m.env);
+	struct item *items = malloc((n + !n) * sizeof(*items));
+	assert(items != NULL);
+
+	bool integral = !o->function;
+	bool real     = !o->function;
+	bool string   = !o->function;
+	for(size_t i = 0; i < n; ++i) {
+		Ast ast = deref(env_element(arr->m.env, i));
+		items[i].ast   = ast;
+		items[i].index = i;
+		switch(ast_type(ast)) {
+		case AST_Zen:
+			items[i].key.u = 0;
+			string         = false;
+			break;
+		case AST_Boolean:
+		case AST_Integer:
+		case AST_Character:
+			items[i].key.u = ast->m.ival;
+			real           = false;
+			string         = false;
+			break;
+		case AST_Float:
+			items[i].key.f = ast->m.fval;
+			integral       = false;
+			string         = false;
+			break;
+		case AST_String:
+			integral       = false;
+			real           = false;
+			break;
+		default:
+			integral       = false;
+			real           = false;
+			string         = false;
+			break;
+		}
+	}
+
+	o->kind = integral ? ORDER_Integer
+		: real ? ORDER_Float
+		: string ? ORDER_String
+		: ORDER_Any;
+
+	return items;
+}
+
+static void
+merge_sort(
+	struct order *o,
+	struct item  *items,
+	struct item  *temp,
+	size_t        n
+) {
+	if(n < 2) {
+		return;
+	}
+
+	size_t const m = n / 2;
+	merge_sort(o, items, temp, m);
+	merge_sort(o, items + m, temp + m, n - m);
+
+	if(!order_less(o, &items[m], &items[m - 1])) {
+		return;
+	}
+
+	memcpy(temp, items, n * sizeof(*items));
+	size_t i = 0, j = m, k = 0;
+	while((i < m) && (j < n)) {
+		items[k++] = order_less(o, &temp[j], &temp[i]) ? temp[j++] : temp[i++];
+	}
+	while(i < m) {
+		items[k++] = temp[i++];
+	}
+	while(j < n) {
+		items[k++] = temp[j++];
+	}
+}
+
+static void
+sort_items(
+	struct order *o,
+	struct item  *items,
+	size_t        n
+) {
+	struct item *temp = malloc((n + !n) * sizeof(*temp));
+	assert(temp != NULL);
+	merge_sort(o, items, temp, n);
+	free(temp);
+}
+
+static void
+sift_down(
+	struct order *o,
+	struct item  *heap,
+	size_t        n,
+	size_t        i
+) {
+	for(size_t c; (c = (2 * i) + 1) < n; i = c) {
+		if(((c + 1) < n) && order_before(o, &heap[c], &heap[c + 1])) {
+			++c;
+		}
+		if(!order_before(o, &heap[i], &heap[c])) {
+			break;
+		}
+		struct item t = heap[i];
+		heap[i]       = heap[c];
+		heap[c]       = t;
+	}
+}
+
+static int
+by_index(
+	void const *l,
+	void const *r
+) {
+	size_t const li = ((struct item const *)l)->index;
+	size_t const ri = ((struct item const *)r)->index;
+	return (li > ri) - (li < ri);
+}
+
+// Leaves the k first items, in order, at the front of items.
+static void
+select_items(
+	struct order *o,
+	struct item  *items,
+	size_t        n,
+	size_t        k
+) {
+	if(k < n) {
+		for(size_t i = k / 2; i-- > 0; ) {
+			sift_down(o, items, k, i);
+		}
+		for(size_t i = k; (i < n) && !o->error; ++i) {
+			if(order_before(o, &items[i], &items[0])) {
+				items[0] = items[i];
+				sift_down(o, items, k, 0);
+			}
+		}
+		qsort(items, k, sizeof(*items), by_index);
+	}
+
+	sort_items(o, items, (k < n) ? k : n);
+}
+
+static Ast
+items_to_array(
+	sloc_t       sloc,
+	struct item *items,
+	size_t       n
+) {
+	Ast arr = new_env(sloc, NULL);
+	if(n > 0) {
+		bool expanded = marray_expand(arr->m.env, sizeof(Ast), n);
+		assert(expanded);
+	}
+	for(size_t i = 0; i < n; ++i) {
+		bool appended = marray_push_back(arr->m.env, Ast, gc_remember(dup_ast(sloc, items[i].ast)));
+		assert(appended);
+	}
+	return arr;
+}
+
+static Ast
+evaluate_arguments(
+	Ast    env,
+	Ast    arg,
+	Ast    argv[],
+	size_t max
+) {
+	size_t argc = 0;
+	for(; ast_isSequence(arg) && ((argc + 1) < max); arg = arg->m.rexpr) {
+		argv[argc++] = gc_push(eval(env, arg->m.lexpr));
+	}
+	argv[argc++] = gc_push(eval(env, arg));
+	while(argc < max) {
+		argv[argc++] = NULL;
+	}
+
+	for(size_t i = 0; (i < max) && argv[i]; ++i) {
+		if(ast_isError(argv[i])) {
+			return argv[i];
+		}
+	}
+	return NULL;
+}
+
+static Ast
+builtin_sort(
+	Ast    env,
+	sloc_t sloc,
+	Ast    arg
+) {
+	size_t ts = gc_topof_stack();
+
+	Ast argv[2];
+	Ast err = evaluate_arguments(env, arg, argv, 2);
+	if(!err
+		&& ast_isEnvironment(argv[0])
+		&& (!argv[1] || ast_isApplicable(argv[1]))
+	) {
+		struct order o;
+		order_begin(&o, env, sloc, argv[1]);
+
+		size_t const n     = marray_length(argv[0]->m.env);
+		struct item *items = order_items(&o, argv[0]);
+		sort_items(&o, items, n);
+
+		Ast result = o.error ? o.error : items_to_array(sloc, items, n);
+		free(items);
+		return gc_return(ts, result);
+	}
+
+	gc_revert(ts);
+	return error_or(sloc, err ? err : ZEN, ERR_InvalidOperand);
+}
+
+static Ast
+builtin_select(
+	Ast    env,
+	sloc_t sloc,
+	Ast    arg,
+	bool   nth
+) {
+	size_t ts = gc_topof_stack();
+
+	Ast argv[3];
+	Ast err = evaluate_arguments(env, arg, argv, 3);
+	if(!err
+		&& ast_isEnvironment(argv[0])
+		&& argv[1] && (ast_isInteger(argv[1]) || ast_isBoolean(argv[1]) || ast_isCharacter(argv[1]))
+		&& (!argv[2] || ast_isApplicable(argv[2]))
+	) {
+		size_t const n = marray_length(argv[0]->m.env);
+		size_t const k = argv[1]->m.ival;
+		if(!nth || (k < n)) {
+			struct order o;
+			order_begin(&o, env, sloc, argv[2]);
+
+			struct item *items = order_items(&o, argv[0]);
+			select_items(&o, items, n, nth ? (k + 1) : k);
+
+			Ast result = o.error ? (
+				o.error
+			) : nth ? (
+				dup_ast(sloc, items[k].ast)
+			) : (
+				items_to_array(sloc, items, (k < n) ? k : n)
+			);
+			free(items);
+			return gc_return(ts, result);
+		}
+	}
+
+	gc_revert(ts);
+	return error_or(sloc, err ? err : ZEN, ERR_InvalidOperand);
+}
+
+static Ast
+builtin_nth(
+	Ast    env,
+	sloc_t sloc,
+	Ast    arg
+) {
+	return builtin_select(env, sloc, arg, true);
+}
+
+static Ast
+builtin_top(
+	Ast    env,
+	sloc_t sloc,
+	Ast    arg
+) {
+	return builtin_select(env, sloc, arg, false);
+}
+
+static Ast
+builtin_lower_bound(
+	Ast    env,
+	sloc_t sloc,
+	Ast    arg
+) {
+	size_t ts = gc_topof_stack();
+
+	Ast argv[3];
+	Ast err = evaluate_arguments(env, arg, argv, 3);
+	if(!err
+		&& ast_isEnvironment(argv[0])
+		&& argv[1]
+		&& (!argv[2] || ast_isApplicable(argv[2]))
+	) {
+		struct order o;
+		order_begin(&o, env, sloc, argv[2]);
+
+		struct item key = { argv[1], 0, { 0 } };
+		size_t      lo  = 0;
+		size_t      hi  = marray_length(argv[0]->m.env);
+		while((lo < hi) && !o.error) {
+			size_t const mid  = lo + ((hi - lo) / 2);
+			struct item  item = { deref(env_element(argv[0]->m.env, mid)), mid, { 0 } };
+			if(order_less(&o, &item, &key)) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+
+		Ast result = o.error ? o.error : new_ast(sloc, AST_Integer, (uint64_t)lo);
+		return gc_return(ts, result);
+	}
+
+	gc_revert(ts);
+	return error_or(sloc, err ? err : ZEN, ERR_InvalidOperand);
+}
+
+//------------------------------------------------------------------------------
+
 int
 initialise_system_environment(
 	bool no_alias
@@ -1101,6 +2020,18 @@ initialise_system_environment(
 		BUILTIN("load"        , load)
 		BUILTIN("import"      , import)
 		BUILTIN("exit"        , exit)
+		BUILTIN("sum"         , sum)
+		BUILTIN("product"     , product)
+		BUILTIN("min"         , min)
+		BUILTIN("max"         , max)
+		BUILTIN("dot"         , dot)
+		BUILTIN("map"         , map)
+		BUILTIN("filter"      , filter)
+		BUILTIN("fold"        , fold)
+		BUILTIN("sort"        , sort)
+		BUILTIN("nth"         , nth)
+		BUILTIN("top"         , top)
+		BUILTIN("lower_bound" , lower_bound)
 	};
 	static size_t const n_builtinfn = sizeof(builtinfn) / sizeof(builtinfn[0]);
 
@@ -54,6 +54,11 @@ initialise_system_bits(
 	bool no_alias
 );
 
+extern int
+initialise_system_vector(
+	bool no_alias
+);
+
 //------------------------------------------------------------------------------
 
 extern Ast
@@ -97,6 +102,80 @@ builtin_printerr(
 
 //------------------------------------------------------------------------------
 
+// system_vector
+
+typedef enum {
+	VECTOR_add,
+	VECTOR_sub,
+	VECTOR_mul,
+	VECTOR_div,
+	VECTOR_mod,
+	VECTOR_and,
+	VECTOR_or,
+	VECTOR_xor,
+	VECTOR_shl,
+	VECTOR_shr,
+	VECTOR_exl,
+	VECTOR_exr,
+	VECTOR_rol,
+	VECTOR_ror
+} VectorOp;
+
+typedef enum {
+	REDUCE_sum,
+	REDUCE_product,
+	REDUCE_min,
+	REDUCE_max
+} Reduce;
+
+extern bool
+ast_isVector(
+	Ast ast
+);
+
+extern size_t
+vector_length(
+	Ast ast
+);
+
+extern Ast
+vector_element(
+	sloc_t sloc,
+	Ast    ast,
+	size_t index
+);
+
+extern Ast
+vector_operate(
+	sloc_t   sloc,
+	Ast      lexpr,
+	Ast      rexpr,
+	VectorOp op
+);
+
+extern Ast
+vector_reduce(
+	sloc_t sloc,
+	Ast    ast,
+	Reduce op
+);
+
+extern Ast
+vector_dot(
+	sloc_t sloc,
+	Ast    lexpr,
+	Ast    rexpr
+);
+
+extern Ast
+pack_vector(
+	sloc_t sloc,
+	Ast    arr,
+	bool   homogeneous
+);
+
+//------------------------------------------------------------------------------
+
 #ifdef __cplusplus
 }
 #endif
@@ -157,8 +157,9 @@ builtin_is_ctype(
 		}
 		if((off < len) && (off <= end)) {
 			if(off > 0) {
-				end = utf8off(cs, NULL, end);
-				off = utf8off(cs, &cs, off);
+				end = StringCodePointOffset(arg->m.sval, end);
+				off = StringCodePointOffset(arg->m.sval, off);
+				cs += off;
 			}
 			do {
 				char32_t c = utf8chr(cs, &cs);
@@ -323,8 +324,9 @@ builtin_span_InSet_delegate(
 
 			if((off < len) && (off <= end)) {
 				if(off > 0) {
-					end = utf8off(cs, NULL, end);
-					off = utf8off(cs, &cs, off);
+					end = StringCodePointOffset(lexpr->m.sval, end);
+					off = StringCodePointOffset(lexpr->m.sval, off);
+					cs += off;
 				}
 
 				if(q != '\0') for(char32_t c; *cs && ~(c = utf8chr(cs, &cs)); ) {
@@ -466,8 +468,9 @@ builtin_span_RevInSet_delegate(
 
 			if((off < len) && (off <= end)) {
 				if(off > 0) {
-					end = utf8off(cs, NULL, end);
-					off = utf8off(cs, &cs, off);
+					end = StringCodePointOffset(lexpr->m.sval, end);
+					off = StringCodePointOffset(lexpr->m.sval, off);
+					cs += off;
 				}
 
 				char const *ce;
@@ -674,8 +677,9 @@ builtin_span_ctype_delegate(
 		}
 		if((off < len) && (off <= end)) {
 			if(off > 0) {
-				end = utf8off(cs, NULL, end);
-				off = utf8off(cs, &cs, off);
+				end = StringCodePointOffset(arg->m.sval, end);
+				off = StringCodePointOffset(arg->m.sval, off);
+				cs += off;
 			}
 
 			for(char32_t c; *cs && ~(c = utf8chr(cs, &cs)); ) {
@@ -774,8 +778,9 @@ builtin_span_rev_ctype_delegate(
 		}
 		if((off < len) && (off <= end)) {
 			if(off > 0) {
-				end = utf8off(cs, NULL, end);
-				off = utf8off(cs, &cs, off);
+				end = StringCodePointOffset(arg->m.sval, end);
+				off = StringCodePointOffset(arg->m.sval, off);
+				cs += off;
 			}
 
 			char const *ce;
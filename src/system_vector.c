@@ -0,0 +1,860 @@
+/*
+MIT License
+
+Copyright (c) 2019 Tristan Styles
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "builtins.h"
+#include "system.h"
+#include "assert.h"
+#include "eval.h"
+#include "env.h"
+#include "odt.h"
+#include "gc.h"
+#include <stdlib.h>
+#include <stdarg.h>
+#include <math.h>
+
+#if defined(__AVX2__)
+#	include <immintrin.h>
+#elif defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
+
+//------------------------------------------------------------------------------
+
+static unsigned builtin_vector_type    = -1u;
+
+static unsigned builtin_is_Vector_enum = -1u;
+static unsigned builtin_to_Vector_enum = -1u;
+static unsigned builtin_to_Array_enum  = -1u;
+
+//------------------------------------------------------------------------------
+
+union element {
+	uint64_t u;
+	double   f;
+};
+
+struct vector {
+	size_t        length;
+	bool          real;
+	union element e[];
+};
+
+static struct vector *
+alloc_vector(
+	size_t length,
+	bool   real
+) {
+	struct vector *v = malloc(sizeof(*v) + (length * sizeof(v->e[0])));
+	assert(v != NULL);
+	v->length = length;
+	v->real   = real;
+	return v;
+}
+
+//------------------------------------------------------------------------------
+
+static Ast
+builtin_vector_type_new(
+	Ast     ast,
+	va_list va
+) {
+	ast->m.lptr = gc_link(va_arg(va, struct vector *));
+	return ast;
+}
+
+static Ast
+builtin_vector_type_eval(
+	Ast ast
+) {
+	return ast;
+}
+
+static void
+builtin_vector_type_mark(
+	Ast    ast,
+	void (*gc_mark)(void const *)
+) {
+	gc_mark(ast->m.lptr);
+}
+
+static void
+builtin_vector_type_sweep(
+	Ast ast
+) {
+	(void)ast;
+}
+
+bool
+ast_isVector(
+	Ast ast
+) {
+	return ast_isType(ast, builtin_vector_type);
+}
+
+size_t
+vector_length(
+	Ast ast
+) {
+	struct vector const *v = ast->m.lptr;
+	return v->length;
+}
+
+Ast
+vector_element(
+	sloc_t sloc,
+	Ast    ast,
+	size_t index
+) {
+	struct vector const *v = ast->m.lptr;
+	if(index < v->length) {
+		return v->real ? (
+			new_ast(sloc, AST_Float, v->e[index].f)
+		) : (
+			new_ast(sloc, AST_Integer, v->e[index].u)
+		);
+	}
+
+	return oboerr(sloc, ERR_InvalidOperand);
+}
+
+//------------------------------------------------------------------------------
+
+typedef void (*Kernel)(
+	size_t               n,
+	union element       *d,
+	union element const *l,
+	union element const *r
+);
+
+#define INTEGER_KERNEL(Name) \
+	static void \
+	integer_kernel_##Name( \
+		size_t               n, \
+		union element       *d, \
+		union element const *l, \
+		union element const *r  \
+	) { \
+		size_t i = 0; \
+		INTEGER_SIMD_##Name \
+		for(; i < n; ++i) { \
+			d[i].u = integer_##Name(l[i].u, r[i].u); \
+		} \
+	}
+
+#define FLOAT_KERNEL(Name) \
+	static void \
+	float_kernel_##Name( \
+		size_t               n, \
+		union element       *d, \
+		union element const *l, \
+		union element const *r  \
+	) { \
+		size_t i = 0; \
+		FLOAT_SIMD_##Name \
+		for(; i < n; ++i) { \
+			d[i].f = float_##Name(l[i].f, r[i].f); \
+		} \
+	}
+
+#define SCALAR_LOOP
+
+#if defined(__AVX2__)
+
+#define SIMD_LANES  4
+
+#define INTEGER_LOOP(Expr) \
+	for(; (i + SIMD_LANES) <= n; i += SIMD_LANES) { \
+		__m256i const lv = _mm256_loadu_si256((__m256i const *)&l[i]); \
+		__m256i const rv = _mm256_loadu_si256((__m256i const *)&r[i]); \
+		_mm256_storeu_si256((__m256i *)&d[i], (Expr)); \
+	}
+
+#define FLOAT_LOOP(Expr) \
+	for(; (i + SIMD_LANES) <= n; i += SIMD_LANES) { \
+		__m256d const lv = _mm256_loadu_pd(&l[i].f); \
+		__m256d const rv = _mm256_loadu_pd(&r[i].f); \
+		__m256d const ok = _mm256_cmp_pd(lv, rv, _CMP_ORD_Q); \
+		_mm256_storeu_pd(&d[i].f, _mm256_and_pd(ok, (Expr))); \
+	}
+
+#define INTEGER_SIMD_add  INTEGER_LOOP(_mm256_add_epi64(lv, rv))
+#define INTEGER_SIMD_sub  INTEGER_LOOP(_mm256_sub_epi64(lv, rv))
+#define INTEGER_SIMD_and  INTEGER_LOOP(_mm256_and_si256(lv, rv))
+#define INTEGER_SIMD_or   INTEGER_LOOP(_mm256_or_si256(lv, rv))
+#define INTEGER_SIMD_xor  INTEGER_LOOP(_mm256_xor_si256(lv, rv))
+#define INTEGER_SIMD_shl  INTEGER_LOOP(_mm256_sllv_epi64(lv, _mm256_and_si256(rv, _mm256_set1_epi64x(63))))
+#define INTEGER_SIMD_shr  INTEGER_LOOP(_mm256_srlv_epi64(lv, _mm256_and_si256(rv, _mm256_set1_epi64x(63))))
+
+#define FLOAT_SIMD_add    FLOAT_LOOP(_mm256_add_pd(lv, rv))
+#define FLOAT_SIMD_sub    FLOAT_LOOP(_mm256_sub_pd(lv, rv))
+#define FLOAT_SIMD_mul    FLOAT_LOOP(_mm256_mul_pd(lv, rv))
+#define FLOAT_SIMD_div    FLOAT_LOOP(_mm256_and_pd(_mm256_cmp_pd(rv, _mm256_setzero_pd(), _CMP_NEQ_OQ), _mm256_div_pd(lv, rv)))
+
+#elif defined(__SSE2__)
+
+#define SIMD_LANES  2
+
+#define INTEGER_LOOP(Expr) \
+	for(; (i + SIMD_LANES) <= n; i += SIMD_LANES) { \
+		__m128i const lv = _mm_loadu_si128((__m128i const *)&l[i]); \
+		__m128i const rv = _mm_loadu_si128((__m128i const *)&r[i]); \
+		_mm_storeu_si128((__m128i *)&d[i], (Expr)); \
+	}
+
+#define FLOAT_LOOP(Expr) \
+	for(; (i + SIMD_LANES) <= n; i += SIMD_LANES) { \
+		__m128d const lv = _mm_loadu_pd(&l[i].f); \
+		__m128d const rv = _mm_loadu_pd(&r[i].f); \
+		__m128d const ok = _mm_cmpord_pd(lv, rv); \
+		_mm_storeu_pd(&d[i].f, _mm_and_pd(ok, (Expr))); \
+	}
+
+#define INTEGER_SIMD_add  INTEGER_LOOP(_mm_add_epi64(lv, rv))
+#define INTEGER_SIMD_sub  INTEGER_LOOP(_mm_sub_epi64(lv, rv))
+#define INTEGER_SIMD_and  INTEGER_LOOP(_mm_and_si128(lv, rv))
+#define INTEGER_SIMD_or   INTEGER_LOOP(_mm_or_si128(lv, rv))
+#define INTEGER_SIMD_xor  INTEGER_LOOP(_mm_xor_si128(lv, rv))
+#define INTEGER_SIMD_shl  SCALAR_LOOP
+#define INTEGER_SIMD_shr  SCALAR_LOOP
+
+#define FLOAT_SIMD_add    FLOAT_LOOP(_mm_add_pd(lv, rv))
+#define FLOAT_SIMD_sub    FLOAT_LOOP(_mm_sub_pd(lv, rv))
+#define FLOAT_SIMD_mul    FLOAT_LOOP(_mm_mul_pd(lv, rv))
+#define FLOAT_SIMD_div    FLOAT_LOOP(_mm_and_pd(_mm_cmpneq_pd(rv, _mm_setzero_pd()), _mm_div_pd(lv, rv)))
+
+#else
+
+#define INTEGER_SIMD_add  SCALAR_LOOP
+#define INTEGER_SIMD_sub  SCALAR_LOOP
+#define INTEGER_SIMD_and  SCALAR_LOOP
+#define INTEGER_SIMD_or   SCALAR_LOOP
+#define INTEGER_SIMD_xor  SCALAR_LOOP
+#define INTEGER_SIMD_shl  SCALAR_LOOP
+#define INTEGER_SIMD_shr  SCALAR_LOOP
+
+#define FLOAT_SIMD_add    SCALAR_LOOP
+#define FLOAT_SIMD_sub    SCALAR_LOOP
+#define FLOAT_SIMD_mul    SCALAR_LOOP
+#define FLOAT_SIMD_div    SCALAR_LOOP
+
+#endif
+
+#define INTEGER_SIMD_mul  SCALAR_LOOP
+#define INTEGER_SIMD_div  SCALAR_LOOP
+#define INTEGER_SIMD_mod  SCALAR_LOOP
+#define INTEGER_SIMD_exl  SCALAR_LOOP
+#define INTEGER_SIMD_exr  SCALAR_LOOP
+#define INTEGER_SIMD_rol  SCALAR_LOOP
+#define INTEGER_SIMD_ror  SCALAR_LOOP
+#define FLOAT_SIMD_mod    SCALAR_LOOP
+
+INTEGER_KERNEL(add)
+INTEGER_KERNEL(sub)
+INTEGER_KERNEL(mul)
+INTEGER_KERNEL(div)
+INTEGER_KERNEL(mod)
+INTEGER_KERNEL(and)
+INTEGER_KERNEL(or )
+INTEGER_KERNEL(xor)
+INTEGER_KERNEL(shl)
+INTEGER_KERNEL(shr)
+INTEGER_KERNEL(exl)
+INTEGER_KERNEL(exr)
+INTEGER_KERNEL(rol)
+INTEGER_KERNEL(ror)
+
+FLOAT_KERNEL(add)
+FLOAT_KERNEL(sub)
+FLOAT_KERNEL(mul)
+FLOAT_KERNEL(div)
+FLOAT_KERNEL(mod)
+
+typedef enum {
+	PROMOTE_Arithmetic,
+	PROMOTE_Bitwise,
+	PROMOTE_Bitmove
+} Promote;
+
+static struct {
+	Promote promote;
+	Kernel  integer;
+	Kernel  real;
+} const kernels[] = {
+	[VECTOR_add] = { PROMOTE_Arithmetic, integer_kernel_add, float_kernel_add },
+	[VECTOR_sub] = { PROMOTE_Arithmetic, integer_kernel_sub, float_kernel_sub },
+	[VECTOR_mul] = { PROMOTE_Arithmetic, integer_kernel_mul, float_kernel_mul },
+	[VECTOR_div] = { PROMOTE_Arithmetic, integer_kernel_div, float_kernel_div },
+	[VECTOR_mod] = { PROMOTE_Arithmetic, integer_kernel_mod, float_kernel_mod },
+	[VECTOR_and] = { PROMOTE_Bitwise   , integer_kernel_and, NULL },
+	[VECTOR_or ] = { PROMOTE_Bitwise   , integer_kernel_or , NULL },
+	[VECTOR_xor] = { PROMOTE_Bitwise   , integer_kernel_xor, NULL },
+	[VECTOR_shl] = { PROMOTE_Bitmove   , integer_kernel_shl, NULL },
+	[VECTOR_shr] = { PROMOTE_Bitmove   , integer_kernel_shr, NULL },
+	[VECTOR_exl] = { PROMOTE_Bitmove   , integer_kernel_exl, NULL },
+	[VECTOR_exr] = { PROMOTE_Bitmove   , integer_kernel_exr, NULL },
+	[VECTOR_rol] = { PROMOTE_Bitmove   , integer_kernel_rol, NULL },
+	[VECTOR_ror] = { PROMOTE_Bitmove   , integer_kernel_ror, NULL },
+};
+
+//------------------------------------------------------------------------------
+
+struct operand {
+	struct vector const *vector;
+	union element        value;
+	bool                 real;
+};
+
+static bool
+operand(
+	struct operand *o,
+	Ast             ast
+) {
+	o->vector = NULL;
+	switch(ast_type(ast)) {
+	case AST_Zen:
+		o->value.u = 0;
+		o->real    = false;
+		return true;
+	case AST_Boolean:
+	case AST_Integer:
+	case AST_Character:
+		o->value.u = ast->m.ival;
+		o->real    = false;
+		return true;
+	case AST_Float:
+		o->value.f = ast->m.fval;
+		o->real    = true;
+		return true;
+	default:
+		if(ast_isVector(ast)) {
+			o->vector = ast->m.lptr;
+			o->real   = o->vector->real;
+			return true;
+		}
+		return false;
+	}
+}
+
+typedef enum {
+	AS_Bits,
+	AS_Float,
+	AS_Integer
+} As;
+
+static inline union element
+convert(
+	union element e,
+	bool          real,
+	As            as
+) {
+	if(real) {
+		if(as == AS_Integer) {
+			e.u = (uint64_t)e.f;
+		}
+	} else if(as == AS_Float) {
+		e.f = (double)e.u;
+	}
+	return e;
+}
+
+static union element const *
+elements(
+	struct operand const *o,
+	size_t                n,
+	As                    as,
+	union element       **temp
+) {
+	struct vector const *v = o->vector;
+	bool const keep = (as == AS_Bits) || ((as == AS_Float) == o->real);
+
+	*temp = NULL;
+	if(v && (v->length == n) && keep) {
+		return v->e;
+	}
+
+	union element *e = malloc(n * sizeof(*e));
+	assert(e != NULL);
+	if(v) {
+		size_t i = 0;
+		for(; i < v->length; ++i) {
+			e[i] = convert(v->e[i], o->real, as);
+		}
+		for(; i < n; ++i) {
+			e[i].u = 0;
+		}
+	} else {
+		union element const value = convert(o->value, o->real, as);
+		for(size_t i = 0; i < n; ++i) {
+			e[i] = value;
+		}
+	}
+
+	*temp = e;
+	return e;
+}
+
+Ast
+vector_operate(
+	sloc_t   sloc,
+	Ast      lexpr,
+	Ast      rexpr,
+	VectorOp op
+) {
+	struct operand l, r;
+
+	if(!operand(&l, lexpr)) {
+		return error_or(sloc, lexpr, ERR_InvalidOperand);
+	}
+	if(!operand(&r, rexpr)) {
+		return error_or(sloc, rexpr, ERR_InvalidOperand);
+	}
+
+	size_t n = 0;
+	if(l.vector) {
+		n = l.vector->length;
+	}
+	if(r.vector && (n < r.vector->length)) {
+		n = r.vector->length;
+	}
+
+	Promote const promote = kernels[op].promote;
+	bool    const real    = (promote == PROMOTE_Arithmetic) && (l.real || r.real);
+	As      const las     = real ? AS_Float : AS_Bits;
+	As      const ras     = real ? AS_Float : ((promote == PROMOTE_Bitmove) ? AS_Integer : AS_Bits);
+
+	union element       *ltemp, *rtemp;
+	union element const *le = elements(&l, n, las, &ltemp);
+	union element const *re = elements(&r, n, ras, &rtemp);
+
+	struct vector *v = alloc_vector(n, real);
+	if(real) {
+		kernels[op].real(n, v->e, le, re);
+	} else {
+		kernels[op].integer(n, v->e, le, re);
+	}
+
+	free(ltemp);
+	free(rtemp);
+
+	return new_ast(sloc, AST_OpaqueDataType, builtin_vector_type, v);
+}
+
+//------------------------------------------------------------------------------
+
+static uint64_t
+integer_reduce_sum(
+	size_t               n,
+	union element const *e
+) {
+	uint64_t acc = 0;
+	size_t   i   = 0;
+#if defined(__AVX2__)
+	__m256i vacc = _mm256_setzero_si256();
+	for(; (i + SIMD_LANES) <= n; i += SIMD_LANES) {
+		vacc = _mm256_add_epi64(vacc, _mm256_loadu_si256((__m256i const *)&e[i]));
+	}
+	uint64_t lanes[SIMD_LANES];
+	_mm256_storeu_si256((__m256i *)lanes, vacc);
+	acc = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(__SSE2__)
+	__m128i vacc = _mm_setzero_si128();
+	for(; (i + SIMD_LANES) <= n; i += SIMD_LANES) {
+		vacc = _mm_add_epi64(vacc, _mm_loadu_si128((__m128i const *)&e[i]));
+	}
+	uint64_t lanes[SIMD_LANES];
+	_mm_storeu_si128((__m128i *)lanes, vacc);
+	acc = lanes[0] + lanes[1];
+#endif
+	for(; i < n; ++i) {
+		acc += e[i].u;
+	}
+	return acc;
+}
+
+static uint64_t
+integer_reduce_product(
+	size_t               n,
+	union element const *e
+) {
+	uint64_t acc = 1;
+	for(size_t i = 0; (i < n) && (acc != 0); ++i) {
+		acc *= e[i].u;
+	}
+	return acc;
+}
+
+static uint64_t
+integer_reduce_min(
+	size_t               n,
+	union element const *e
+) {
+	uint64_t acc = e[0].u;
+	size_t   i   = 1;
+#if defined(__AVX2__)
+	__m256i const sign = _mm256_set1_epi64x(INT64_MIN);
+	__m256i       vacc = _mm256_set1_epi64x(acc);
+	for(; (i + SIMD_LANES) <= n; i += SIMD_LANES) {
+		__m256i const x  = _mm256_loadu_si256((__m256i const *)&e[i]);
+		__m256i const gt = _mm256_cmpgt_epi64(_mm256_xor_si256(vacc, sign), _mm256_xor_si256(x, sign));
+		vacc = _mm256_blendv_epi8(vacc, x, gt);
+	}
+	uint64_t lanes[SIMD_LANES];
+	_mm256_storeu_si256((__m256i *)lanes, vacc);
+	for(size_t j = 0; j < SIMD_LANES; ++j) {
+		if(lanes[j] < acc) acc = lanes[j];
+	}
+#endif
+	for(; i < n; ++i) {
+		if(e[i].u < acc) acc = e[i].u;
+	}
+	return acc;
+}
+
+static uint64_t
+integer_reduce_max(
+	size_t               n,
+	union element const *e
+) {
+	uint64_t acc = e[0].u;
+	size_t   i   = 1;
+#if defined(__AVX2__)
+	__m256i const sign = _mm256_set1_epi64x(INT64_MIN);
+	__m256i       vacc = _mm256_set1_epi64x(acc);
+	for(; (i + SIMD_LANES) <= n; i += SIMD_LANES) {
+		__m256i const x  = _mm256_loadu_si256((__m256i const *)&e[i]);
+		__m256i const gt = _mm256_cmpgt_epi64(_mm256_xor_si256(x, sign), _mm256_xor_si256(vacc, sign));
+		vacc = _mm256_blendv_epi8(vacc, x, gt);
+	}
+	uint64_t lanes[SIMD_LANES];
+	_mm256_storeu_si256((__m256i *)lanes, vacc);
+	for(size_t j = 0; j < SIMD_LANES; ++j) {
+		if(lanes[j] > acc) acc = lanes[j];
+	}
+#endif
+	for(; i < n; ++i) {
+		if(e[i].u > acc) acc = e[i].u;
+	}
+	return acc;
+}
+
+// Float sums and products accumulate in element order, so that they round
+// exactly as the equivalent scripted loop does.
+
+static double
+float_reduce_sum(
+	size_t               n,
+	union element const *e
+) {
+	double acc = 0.0;
+	for(size_t i = 0; i < n; ++i) {
+		acc = float_add(acc, e[i].f);
+	}
+	return acc;
+}
+
+static double
+float_reduce_product(
+	size_t               n,
+	union element const *e
+) {
+	double acc = 1.0;
+	for(size_t i = 0; i < n; ++i) {
+		acc = float_mul(acc, e[i].f);
+	}
+	return acc;
+}
+
+static inline bool
+float_lt(
+	double lval,
+	double rval
+) {
+	return !isunordered(lval, rval) && isless(lval, rval);
+}
+
+static double
+float_reduce_min(
+	size_t               n,
+	union element const *e
+) {
+	double acc = e[0].f;
+	size_t i   = 1;
+#if defined(__AVX2__)
+	__m256d vacc = _mm256_set1_pd(acc);
+	for(; (i + SIMD_LANES) <= n; i += SIMD_LANES) {
+		vacc = _mm256_min_pd(_mm256_loadu_pd(&e[i].f), vacc);
+	}
+	double lanes[SIMD_LANES];
+	_mm256_storeu_pd(lanes, vacc);
+#elif defined(__SSE2__)
+	__m128d vacc = _mm_set1_pd(acc);
+	for(; (i + SIMD_LANES) <= n; i += SIMD_LANES) {
+		vacc = _mm_min_pd(_mm_loadu_pd(&e[i].f), vacc);
+	}
+	double lanes[SIMD_LANES];
+	_mm_storeu_pd(lanes, vacc);
+#endif
+#ifdef SIMD_LANES
+	for(size_t j = 0; j < SIMD_LANES; ++j) {
+		if(float_lt(lanes[j], acc)) acc = lanes[j];
+	}
+#endif
+	for(; i < n; ++i) {
+		if(float_lt(e[i].f, acc)) acc = e[i].f;
+	}
+	return acc;
+}
+
+static double
+float_reduce_max(
+	size_t               n,
+	union element const *e
+) {
+	double acc = e[0].f;
+	size_t i   = 1;
+#if defined(__AVX2__)
+	__m256d vacc = _mm256_set1_pd(acc);
+	for(; (i + SIMD_LANES) <= n; i += SIMD_LANES) {
+		vacc = _mm256_max_pd(_mm256_loadu_pd(&e[i].f), vacc);
+	}
+	double lanes[SIMD_LANES];
+	_mm256_storeu_pd(lanes, vacc);
+#elif defined(__SSE2__)
+	__m128d vacc = _mm_set1_pd(acc);
+	for(; (i + SIMD_LANES) <= n; i += SIMD_LANES) {
+		vacc = _mm_max_pd(_mm_loadu_pd(&e[i].f), vacc);
+	}
+	double lanes[SIMD_LANES];
+	_mm_storeu_pd(lanes, vacc);
+#endif
+#ifdef SIMD_LANES
+	for(size_t j = 0; j < SIMD_LANES; ++j) {
+		if(float_lt(acc, lanes[j])) acc = lanes[j];
+	}
+#endif
+	for(; i < n; ++i) {
+		if(float_lt(acc, e[i].f)) acc = e[i].f;
+	}
+	return acc;
+}
+
+static struct {
+	uint64_t (*integer)(size_t, union element const *);
+	double   (*real   )(size_t, union element const *);
+} const reducers[] = {
+	[REDUCE_sum    ] = { integer_reduce_sum    , float_reduce_sum     },
+	[REDUCE_product] = { integer_reduce_product, float_reduce_product },
+	[REDUCE_min    ] = { integer_reduce_min    , float_reduce_min     },
+	[REDUCE_max    ] = { integer_reduce_max    , float_reduce_max     },
+};
+
+Ast
+vector_reduce(
+	sloc_t sloc,
+	Ast    ast,
+	Reduce op
+) {
+	struct vector const *v = ast->m.lptr;
+
+	if(v->length == 0) {
+		switch(op) {
+		case REDUCE_sum:
+			return new_ast(sloc, AST_Integer, UINT64_C(0));
+		case REDUCE_product:
+			return new_ast(sloc, AST_Integer, UINT64_C(1));
+		default:
+			return ZEN;
+		}
+	}
+
+	if(v->real) {
+		double const result = reducers[op].real(v->length, v->e);
+		return new_ast(sloc, AST_Float, result);
+	}
+
+	uint64_t const result = reducers[op].integer(v->length, v->e);
+	return new_ast(sloc, AST_Integer, result);
+}
+
+Ast
+vector_dot(
+	sloc_t sloc,
+	Ast    lexpr,
+	Ast    rexpr
+) {
+	struct vector const *l = lexpr->m.lptr;
+	struct vector const *r = rexpr->m.lptr;
+	size_t const         n = (l->length < r->length) ? l->length : r->length;
+
+	if(l->real || r->real) {
+		double acc = 0.0;
+		for(size_t i = 0; i < n; ++i) {
+			double const lval = l->real ? l->e[i].f : (double)l->e[i].u;
+			double const rval = r->real ? r->e[i].f : (double)r->e[i].u;
+			acc = float_add(acc, float_mul(lval, rval));
+		}
+		return new_ast(sloc, AST_Float, acc);
+	}
+
+	uint64_t acc = 0;
+	for(size_t i = 0; i < n; ++i) {
+		acc += l->e[i].u * r->e[i].u;
+	}
+	return new_ast(sloc, AST_Integer, acc);
+}
+
+//------------------------------------------------------------------------------
+
+Ast
+pack_vector(
+	sloc_t sloc,
+	Ast    arr,
+	bool   homogeneous
+) {
+	size_t const   n        = marray_length(arr->m.env);
+	struct vector *v        = alloc_vector(n, false);
+	bool           integral = false;
+
+	struct operand o;
+	for(size_t i = 0; i < n; ++i) {
+		Ast value = deref(env_element(arr->m.env, i));
+		if(!operand(&o, value) || o.vector) {
+			free(v);
+			return NULL;
+		}
+		v->e[i]   = o.value;
+		v->real  |= o.real;
+		integral |= !o.real && ast_isnotZen(value);
+	}
+
+	if(v->real && integral) {
+		if(homogeneous) {
+			free(v);
+			return NULL;
+		}
+		for(size_t i = 0; i < n; ++i) {
+			Ast value = deref(env_element(arr->m.env, i));
+			operand(&o, value);
+			v->e[i] = convert(o.value, o.real, AS_Float);
+		}
+	}
+
+	return new_ast(sloc, AST_OpaqueDataType, builtin_vector_type, v);
+}
+
+//------------------------------------------------------------------------------
+
+static Ast
+builtin_is_Vector(
+	Ast    env,
+	sloc_t sloc,
+	Ast    arg
+) {
+	arg = eval(env, arg);
+	uint64_t is = ast_isVector(arg);
+	return new_ast(sloc, AST_Boolean, is);
+}
+
+static Ast
+builtin_to_Vector(
+	Ast    env,
+	sloc_t sloc,
+	Ast    arg
+) {
+	arg = eval(env, arg);
+	if(ast_isVector(arg)) {
+		return arg;
+	}
+
+	struct operand o;
+	if(operand(&o, arg)) {
+		struct vector *v = alloc_vector(1, o.real);
+		v->e[0] = o.value;
+		return new_ast(sloc, AST_OpaqueDataType, builtin_vector_type, v);
+	}
+
+	if(ast_isEnvironment(arg)) {
+		Ast vec = pack_vector(sloc, arg, false);
+		if(vec) {
+			return vec;
+		}
+		return oboerr(sloc, ERR_InvalidOperand);
+	}
+
+	return error_or(sloc, arg, ERR_InvalidOperand);
+}
+
+static Ast
+builtin_to_Array(
+	Ast    env,
+	sloc_t sloc,
+	Ast    arg
+) {
+	arg = eval(env, arg);
+	if(ast_isVector(arg)) {
+		size_t ts = gc_topof_stack();
+
+		struct vector const *v   = arg->m.lptr;
+		Ast                  arr = gc_push(new_env(sloc, NULL));
+		for(size_t i = 0; i < v->length; ++i) {
+			bool appended = marray_push_back(arr->m.env, Ast, gc_remember(vector_element(sloc, arg, i)));
+			assert(appended);
+		}
+
+		return gc_return(ts, arr);
+	}
+
+	return error_or(sloc, arg, ERR_InvalidOperand);
+}
+
+//------------------------------------------------------------------------------
+
+int
+initialise_system_vector(
+	bool no_alias
+) {
+	static struct builtinfn const builtinfn[] = {
+		BUILTIN("is_Vector", is_Vector)
+		BUILTIN("to_Vector", to_Vector)
+		BUILTIN("to_Array" , to_Array)
+	};
+	static size_t const n_builtinfn = sizeof(builtinfn) / sizeof(builtinfn[0]);
+
+	static bool initialise = true;
+
+	if(initialise) {
+		initialise = false;
+
+		builtin_vector_type = add_odt("vector",
+			builtin_vector_type_new,
+			builtin_vector_type_eval,
+			builtin_vector_type_mark,
+			builtin_vector_type_sweep
+		);
+
+		initialise_builtinfn(system_environment, builtinfn, n_builtinfn);
+	}
+
+	return EXIT_SUCCESS;
+	(void)no_alias;
+}
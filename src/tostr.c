@@ -30,15 +30,77 @@ SOFTWARE.
 #include "utf8.h"
 #include "lex.h"
 #include <stdio.h>
+#include <stdlib.h>
 
 //------------------------------------------------------------------------------
 
-static String
-toString(
-	String s,
-	bool   archival,
-	Ast    ast
-);
+// Nested expressions and array elements are not written recursively: what
+// remains to be written is kept on an explicit stack, in reverse order, so
+// the depth of a value is bounded only by memory.
+
+typedef enum {
+	PENDING_Text,
+	PENDING_Expression,
+	PENDING_Element
+} Pending;
+
+struct pending {
+	Pending     kind;
+	char const *text;
+	Ast         ast;
+	size_t      index;
+};
+
+struct pending_stack {
+	struct pending *base;
+	size_t          length;
+	size_t          capacity;
+	bool            failed;
+};
+
+static void
+push_pending(
+	struct pending_stack *stack,
+	Pending               kind,
+	char const           *text,
+	Ast                   ast,
+	size_t                index
+) {
+	if(stack->length == stack->capacity) {
+		size_t          capacity = stack->capacity ? stack->capacity * 2 : 16;
+		struct pending *p        = realloc(stack->base, capacity * sizeof(*p));
+		if(!p) {
+			stack->failed = true;
+			return;
+		}
+		stack->base     = p;
+		stack->capacity = capacity;
+	}
+
+	stack->base[stack->length++] = (struct pending){ kind, text, ast, index };
+}
+
+static inline void
+push_text(
+	struct pending_stack *stack,
+	char const           *text
+) {
+	push_pending(stack, PENDING_Text, text, NULL, 0);
+}
+
+static inline void
+push_expression(
+	struct pending_stack *stack,
+	char const           *prefix,
+	Ast                   value,
+	char const           *postfix
+) {
+	push_text(stack, postfix);
+	if(ast_isnotZen(value)) {
+		push_pending(stack, PENDING_Expression, NULL, value, 0);
+	}
+	push_text(stack, prefix);
+}
 
 static String
 toString_integer(
@@ -165,65 +227,65 @@ toString_lexeme(
 
 static String
 toString_expression(
-	String      s,
-	bool        archival,
-	char const *prefix,
-	Ast         value,
-	char const *postfix
+	String                s,
+	struct pending_stack *stack,
+	char const           *prefix,
+	Ast                   value,
+	char const           *postfix
 ) {
 	s = StringAppendCharLiteral(s, prefix, strlen(prefix));
+	push_text(stack, postfix);
 	if(ast_isnotZen(value)) {
-		s = toString(s, archival, value);
+		push_pending(stack, PENDING_Expression, NULL, value, 0);
 	}
-	s = StringAppendCharLiteral(s, postfix, strlen(postfix));
 
 	return s;
 }
 
 static String
 toString_operator(
-	String      s,
-	bool        archival,
-	char const *prefix,
-	Ast         lexpr,
-	char const *value,
-	Ast         rexpr,
-	char const *postfix
+	String                s,
+	struct pending_stack *stack,
+	char const           *prefix,
+	Ast                   lexpr,
+	char const           *value,
+	Ast                   rexpr,
+	char const           *postfix
 ) {
 	s = StringAppendCharLiteral(s, prefix, strlen(prefix));
-	if(ast_isnotZen(lexpr)) {
-		s = toString_expression(s, archival, "(", lexpr, ")");
+	push_text(stack, postfix);
+	if(ast_isnotZen(rexpr)) {
+		push_expression(stack, "(", rexpr, ")");
 	}
 	if(value && *value) {
-		s = StringAppendCharLiteral(s, value, strlen(value));
+		push_text(stack, value);
 	}
-	if(ast_isnotZen(rexpr)) {
-		s = toString_expression(s, archival, "(", rexpr, ")");
+	if(ast_isnotZen(lexpr)) {
+		push_expression(stack, "(", lexpr, ")");
 	}
-	s = StringAppendCharLiteral(s, postfix, strlen(postfix));
 
 	return s;
 }
 
 static String
 toString_sequence(
-	String      s,
-	bool        archival,
-	char const *prefix,
-	Ast         lexpr,
-	char const *value,
-	Ast         rexpr,
-	char const *postfix
+	String                s,
+	struct pending_stack *stack,
+	char const           *prefix,
+	Ast                   lexpr,
+	char const           *value,
+	Ast                   rexpr,
+	char const           *postfix
 ) {
 	s = StringAppendCharLiteral(s, prefix, strlen(prefix));
-	if(ast_isnotZen(lexpr)) {
-		s = toString_expression(s, archival, "(", lexpr, ")");
-	}
-	s = StringAppendCharLiteral(s, value, strlen(value));
+	push_text(stack, postfix);
 	if(ast_isnotZen(rexpr)) {
-		s = toString_expression(s, archival, "(", rexpr, ")");
+		push_expression(stack, "(", rexpr, ")");
+	}
+	push_text(stack, value);
+	if(ast_isnotZen(lexpr)) {
+		push_expression(stack, "(", lexpr, ")");
 	}
-	s = StringAppendCharLiteral(s, postfix, strlen(postfix));
 
 	return s;
 }
@@ -250,49 +312,50 @@ is_identifier(
 
 static String
 toString_environment(
-	String      s,
-	bool        archival,
-	char const *prefix,
-	Ast         ast,
-	char const *postfix
+	String                s,
+	struct pending_stack *stack,
+	char const           *prefix,
+	Ast                   ast,
+	char const           *postfix
 ) {
 	Array env = ast->m.env;
 
 	s = StringAppendCharLiteral(s, prefix, strlen(prefix));
-	if(env) {
-		size_t const n = marray_length(env);
-		if(n > 0) {
-			Ast value = marray_at(env, Ast, 0);
-			if(ast_isReference(value)) {
-				if(is_identifier(value->m.sval)) {
-					s = toString_expression(s, archival, "(", value, ":");
-				} else {
-					s = toString_expression(s, archival, "(\"", value, "\":");
-				}
-				s = toString_expression(s, archival, "(" , value->m.rexpr, "))");
-			} else {
-				s = toString_expression(s, archival, "(", value, ")");
-			}
-			for(size_t i = 1; i < n; ++i) {
-				value = marray_at(env, Ast, i);
-				if(ast_isReference(value)) {
-					if(is_identifier(value->m.sval)) {
-						s = toString_expression(s, archival, "(", value, ":");
-					} else {
-						s = toString_expression(s, archival, "(\"", value, "\":");
-					}
-					s = toString_expression(s, archival,  "(" , value->m.rexpr, "))");
-				} else {
-					s = toString_expression(s, archival, ",(", value, ")");
-				}
-			}
-		}
+	push_text(stack, postfix);
+	if(env && (marray_length(env) > 0)) {
+		push_pending(stack, PENDING_Element, NULL, ast, 0);
 	}
-	s = StringAppendCharLiteral(s, postfix, strlen(postfix));
 
 	return s;
 }
 
+// Queues the element at index of an environment, after which the next one
+// is written.
+static void
+toString_element(
+	struct pending_stack *stack,
+	Ast                   ast,
+	size_t                index
+) {
+	Array env = ast->m.env;
+
+	if((index + 1) < marray_length(env)) {
+		push_pending(stack, PENDING_Element, NULL, ast, index + 1);
+	}
+
+	Ast value = env_element(env, index);
+	if(ast_isReference(value)) {
+		push_expression(stack, "(" , value->m.rexpr, "))");
+		if(is_identifier(value->m.sval)) {
+			push_expression(stack, "(", value, ":");
+		} else {
+			push_expression(stack, "(\"", value, "\":");
+		}
+	} else {
+		push_expression(stack, index ? ",(" : "(", value, ")");
+	}
+}
+
 static String
 toString_error(
 	String      s,
@@ -326,10 +389,11 @@ toString_error(
 }
 
 static String
-toString(
-	String s,
-	bool   archival,
-	Ast    ast
+toString_value(
+	String                s,
+	bool                  archival,
+	struct pending_stack *stack,
+	Ast                   ast
 ) {
 	if(s) switch(ast_type(ast)) {
 	default: {
@@ -342,10 +406,10 @@ toString(
 #	define STRING(Pre,Val,Post)                s = toString_string     (s, archival, (Pre), (Val), (Post))
 #	define IDENTIFIER(Pre,Val,Post)            s = toString_identifier (s, archival, (Pre), (Val), (Post))
 #	define LEXEME(Pre,Val,Post)                s = toString_lexeme     (s, archival, (Pre), (Val), (Post))
-#	define OPERATOR(Pre,Lexpr,Val,Rexpr,Post)  s = toString_operator   (s, archival, (Pre), (Lexpr), (Val), (Rexpr), (Post))
-#	define SEQUENCE(Pre,Lexpr,Val,Rexpr,Post)  s = toString_sequence   (s, archival, (Pre), (Lexpr), (Val), (Rexpr), (Post))
-#	define EXPRESSION(Pre,Val,Post)            s = toString_expression (s, archival, (Pre), (Val), (Post))
-#	define ENVIRONMENT(Pre,Array,Post)         s = toString_environment(s, archival, (Pre), (Array), (Post))
+#	define OPERATOR(Pre,Lexpr,Val,Rexpr,Post)  s = toString_operator   (s, stack, (Pre), (Lexpr), (Val), (Rexpr), (Post))
+#	define SEQUENCE(Pre,Lexpr,Val,Rexpr,Post)  s = toString_sequence   (s, stack, (Pre), (Lexpr), (Val), (Rexpr), (Post))
+#	define EXPRESSION(Pre,Val,Post)            s = toString_expression (s, stack, (Pre), (Val), (Post))
+#	define ENVIRONMENT(Pre,Array,Post)         s = toString_environment(s, stack, (Pre), (Array), (Post))
 #	define ERRORMESSAGE(Pre,Err,Post)          s = toString_error      (s, archival, (Pre), (Err), (Post))
 #	define OPERATOROF(Qual)                    getops(Qual)
 
@@ -368,6 +432,43 @@ toString(
 	return s;
 }
 
+static String
+toString(
+	String s,
+	bool   archival,
+	Ast    ast
+) {
+	struct pending_stack stack = { NULL, 0, 0, false };
+	struct pending       next  = { PENDING_Expression, NULL, ast, 0 };
+
+	while(s) {
+		switch(next.kind) {
+		case PENDING_Text:
+			s = StringAppendCharLiteral(s, next.text, strlen(next.text));
+			break;
+		case PENDING_Expression:
+			s = toString_value(s, archival, &stack, next.ast);
+			break;
+		case PENDING_Element:
+			toString_element(&stack, next.ast, next.index);
+			break;
+		}
+
+		if(stack.failed) {
+			StringDelete(s);
+			s = NULL;
+			break;
+		}
+		if(stack.length == 0) {
+			break;
+		}
+		next = stack.base[--stack.length];
+	}
+
+	free(stack.base);
+	return s;
+}
+
 //------------------------------------------------------------------------------
 
 String
@@ -4,3 +4,7 @@
 @IF EXIST "./ref/%1.log" (
 	diff -q ./ref/%1.log ./out/%1.log
 )
+@..\oboe -G 64 -o ./out/%1.gc-step.log %*
+@IF EXIST "./ref/%1.log" (
+	diff -q ./ref/%1.log ./out/%1.gc-step.log
+)